@@ -44,6 +44,12 @@ Kirigami.AbstractCard {
     }
     Keys.onReturnPressed: trigger()
     onClicked: trigger()
+    onPressedChanged: {
+        // Get the reviews going while the application is being opened, not for every delegate scrolled by
+        if (pressed && application && application.backend.reviewsBackend) {
+            application.backend.reviewsBackend.prefetchReviews(application)
+        }
+    }
     topPadding: 0
     bottomPadding: 0
     leftPadding: 0
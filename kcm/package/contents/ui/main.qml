@@ -43,6 +43,20 @@ SimpleKCM {
                 settingName: "useUnattendedUpdates"
                 target: automaticallyRadio
             }
+
+            QQC2.CheckBox {
+                id: prefetchCheck
+                text: i18n("Download updates in the background")
+                enabled: !automaticallyRadio.checked
+                checked: kcm.updatesSettings.prefetchUpdates
+                onToggled: kcm.updatesSettings.prefetchUpdates = checked
+            }
+
+            SettingStateBinding {
+                configObject: kcm.updatesSettings
+                settingName: "prefetchUpdates"
+                target: prefetchCheck
+            }
         }
 
         QQC2.Label {
@@ -15,7 +15,20 @@ bool AbstractReviewsBackend::isReviewable() const
     return true;
 }
 
+void AbstractReviewsBackend::prefetchReviews(AbstractResource* app)
+{
+    Q_UNUSED(app)
+}
+
 QString AbstractReviewsBackend::errorMessage() const
 {
     return QString();
 }
+
+QFuture<void> AbstractReviewsBackend::ratingsFuture() const
+{
+    QFutureInterface<void> ready;
+    ready.reportStarted();
+    ready.reportFinished();
+    return ready.future();
+}
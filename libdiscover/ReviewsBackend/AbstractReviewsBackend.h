@@ -8,6 +8,7 @@
 #define ABSTRACTREVIEWSBACKEND_H
 
 #include <QObject>
+#include <QFuture>
 
 #include "ReviewsModel.h"
 
@@ -27,6 +28,12 @@ public:
     virtual bool hasCredentials() const = 0;
 
     Q_SCRIPTABLE virtual Rating *ratingForApplication(AbstractResource *app) const = 0;
+
+    /**
+     * @returns a future that finishes once ratingForApplication() can provide ratings,
+     * by default the ratings are ready right away
+     */
+    virtual QFuture<void> ratingsFuture() const;
     Q_INVOKABLE virtual QString errorMessage() const;
     Q_INVOKABLE virtual bool isResourceSupported(AbstractResource *res) const = 0;
     virtual bool isFetching() const = 0;
@@ -42,6 +49,8 @@ public Q_SLOTS:
     virtual void deleteReview(Review* r) = 0;
     virtual void flagReview(Review* r, const QString& reason, const QString &text) = 0;
     virtual void fetchReviews(AbstractResource* app, int page=1) = 0;
+    /// Hints that the reviews for @p app will likely be needed soon, does nothing by default
+    virtual void prefetchReviews(AbstractResource* app);
 
 Q_SIGNALS:
     void reviewsReady(AbstractResource *app, const QVector<ReviewPtr> &reviews, bool canFetchMore);
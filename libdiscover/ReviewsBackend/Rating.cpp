@@ -8,6 +8,7 @@
 #include <QStringList>
 #include "libdiscover_debug.h"
 #include <qmath.h>
+#include <algorithm>
 
 inline double fastPow(double a, double b) {
     union {
@@ -79,6 +80,11 @@ double dampenedRating(int ratings[6], double power = 0.1)
 }
 
 Rating::Rating(const QString &packageName, quint64 ratingCount, int data[6])
+    : Rating(packageName, ratingCount, data, computeSortableRating(data))
+{
+}
+
+Rating::Rating(const QString &packageName, quint64 ratingCount, int data[6], double sortableRating)
     : m_packageName(packageName)
     , m_ratingCount(ratingCount)
       // TODO consider storing data[] and present in UI
@@ -86,16 +92,18 @@ Rating::Rating(const QString &packageName, quint64 ratingCount, int data[6])
                  (data[3] * 3) + (data[4] * 4) +
                  (data[5] * 5)) * 2) / qMax<float>(1, ratingCount))
     , m_ratingPoints(0)
-    , m_sortableRating(0)
+    , m_sortableRating(sortableRating)
 {
-    int spread[6];
     for (int i=0; i<6; ++i) {
-        int points = data[i];
-        m_ratingPoints += (i+1)*points;
-        spread[i] = points;
+        m_ratingPoints += (i+1)*data[i];
     }
+}
 
-    m_sortableRating = dampenedRating(spread) * 2;
+double Rating::computeSortableRating(int data[6])
+{
+    int spread[6];
+    std::copy(data, data + 6, spread);
+    return dampenedRating(spread) * 2;
 }
 
 Rating::Rating(const QString &packageName, quint64 ratingCount, int rating)
@@ -23,6 +23,8 @@ public:
     Rating() {}
     explicit Rating(const QString &packageName, quint64 ratingCount, int rating);
     explicit Rating(const QString &packageName, quint64 ratingCount, int data[6]);
+    /// Same as above when the sortable rating is known already, see computeSortableRating()
+    explicit Rating(const QString &packageName, quint64 ratingCount, int data[6], double sortableRating);
     ~Rating();
 
     QString packageName() const;
@@ -33,10 +35,13 @@ public:
     // Returns a dampened rating calculated with the Wilson Score Interval algorithm
     double sortableRating() const;
 
+    // The sortableRating() for the given star spread
+    static double computeSortableRating(int data[6]);
+
 private:
-    const QString m_packageName;
-    const quint64 m_ratingCount = 0;
-    const float m_rating = 0;
+    QString m_packageName;
+    quint64 m_ratingCount = 0;
+    float m_rating = 0;
     int m_ratingPoints = 0;
     double m_sortableRating = 0;
 };
@@ -9,10 +9,12 @@
 // Qt includes
 #include <QDebug>
 #include <QMetaProperty>
+#include <QTimer>
 #include <KLocalizedString>
 
 // Own includes
 #include "resources/AbstractResource.h"
+#include "resources/ProgressAggregator.h"
 #include "libdiscover_debug.h"
 
 Q_GLOBAL_STATIC(TransactionModel, globalTransactionModel)
@@ -24,10 +26,16 @@ TransactionModel *TransactionModel::global()
 
 TransactionModel::TransactionModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_progressTimer(new QTimer(this))
 {
     connect(this, &QAbstractItemModel::rowsInserted, this, &TransactionModel::countChanged);
     connect(this, &QAbstractItemModel::rowsRemoved, this, &TransactionModel::countChanged);
     connect(this, &TransactionModel::countChanged, this, &TransactionModel::progressChanged);
+
+    // Transactions report progress very often, the views don't need to know more than once per frame
+    m_progressTimer->setInterval(ProgressAggregator::FlushInterval);
+    m_progressTimer->setSingleShot(true);
+    connect(m_progressTimer, &QTimer::timeout, this, &TransactionModel::emitProgressChanged);
 }
 
 QHash< int, QByteArray > TransactionModel::roleNames() const
@@ -105,21 +113,17 @@ QVariant TransactionModel::data(const QModelIndex &index, int role) const
 
 Transaction *TransactionModel::transactionFromResource(AbstractResource *resource) const
 {
+    // Values of the same key go from the newest to the oldest, return the oldest one
     Transaction *ret = nullptr;
-
-    Q_FOREACH (Transaction *trans, m_transactions) {
-        if (trans->resource() == resource) {
-            ret = trans;
-            break;
-        }
+    for (auto it = m_resourceTransactions.constFind(resource), end = m_resourceTransactions.constEnd(); it != end && it.key() == resource; ++it) {
+        ret = *it;
     }
-
     return ret;
 }
 
 QModelIndex TransactionModel::indexOf(Transaction *trans) const
 {
-    int row = m_transactions.indexOf(trans);
+    int row = m_rows.value(trans, -1);
     QModelIndex ret = index(row);
     Q_ASSERT(!trans || ret.isValid());
     return ret;
@@ -137,15 +141,17 @@ void TransactionModel::addTransaction(Transaction *trans)
     if (!trans)
         return;
 
-    if (m_transactions.contains(trans))
+    if (m_rows.contains(trans))
         return;
 
     if (m_transactions.isEmpty())
         emit startingFirstTransaction();
 
     int before = m_transactions.size();
-    beginInsertRows(QModelIndex(), before, before + 1);
+    beginInsertRows(QModelIndex(), before, before);
     m_transactions.append(trans);
+    m_rows.insert(trans, before);
+    m_resourceTransactions.insert(trans->resource(), trans);
     endInsertRows();
 
     connect(trans, &Transaction::statusChanged, this, [this]() {
@@ -154,9 +160,10 @@ void TransactionModel::addTransaction(Transaction *trans)
     connect(trans, &Transaction::cancellableChanged, this, [this]() {
         transactionChanged(CancellableRole);
     });
-    connect(trans, &Transaction::progressChanged, this, [this]() {
-        transactionChanged(ProgressRole);
-        Q_EMIT progressChanged();
+    connect(trans, &Transaction::progressChanged, this, [this, trans]() {
+        m_progressed.insert(trans);
+        if (!m_progressTimer->isActive())
+            m_progressTimer->start();
     });
 
     emit transactionAdded(trans);
@@ -166,16 +173,21 @@ void TransactionModel::removeTransaction(Transaction *trans, bool isDestroy)
 {
     Q_ASSERT(trans);
     trans->deleteLater();
-    int r = m_transactions.indexOf(trans);
+    int r = m_rows.value(trans, -1);
     if (r<0) {
         qCWarning(LIBDISCOVER_LOG) << "transaction not part of the model" << trans;
         return;
     }
 
     disconnect(trans, nullptr, this, nullptr);
+    m_progressed.remove(trans);
 
     beginRemoveRows(QModelIndex(), r, r);
     m_transactions.removeAt(r);
+    m_rows.remove(trans);
+    for (int i = r, c = m_transactions.size(); i < c; ++i)
+        m_rows[m_transactions.at(i)] = i;
+    m_resourceTransactions.remove(trans->resource(), trans);
     endRemoveRows();
 
     emit transactionRemoved(trans);
@@ -190,6 +202,19 @@ void TransactionModel::transactionChanged(int role)
     emit dataChanged(transIdx, transIdx, {role});
 }
 
+void TransactionModel::emitProgressChanged()
+{
+    if (m_progressed.isEmpty())
+        return;
+
+    for (Transaction *trans : qAsConst(m_progressed)) {
+        const QModelIndex transIdx = indexOf(trans);
+        emit dataChanged(transIdx, transIdx, {ProgressRole});
+    }
+    m_progressed.clear();
+    emit progressChanged();
+}
+
 int TransactionModel::progress() const
 {
     int sum = 0;
@@ -8,11 +8,15 @@
 #define TRANSACTIONMODEL_H
 
 #include <QAbstractListModel>
+#include <QHash>
+#include <QSet>
 
 #include "Transaction.h"
 
 #include "discovercommon_export.h"
 
+class QTimer;
+
 class DISCOVERCOMMON_EXPORT TransactionModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -45,7 +49,7 @@ public:
     void removeTransaction(Transaction *trans,bool isDestroy = false);
 
     bool contains(Transaction* transaction) const {
-        return m_transactions.contains(transaction);
+        return m_rows.contains(transaction);
     }
     int progress() const;
     QVector<Transaction *> transactions() const {
@@ -53,7 +57,14 @@ public:
     }
 
 private:
+    void emitProgressChanged();
+
     QVector<Transaction *> m_transactions;
+    // Kept in sync with m_transactions, these are looked up for every resource delegate
+    QHash<Transaction *, int> m_rows;
+    QMultiHash<AbstractResource *, Transaction *> m_resourceTransactions;
+    QSet<Transaction *> m_progressed;
+    QTimer* const m_progressTimer;
 
 Q_SIGNALS:
     void startingFirstTransaction();
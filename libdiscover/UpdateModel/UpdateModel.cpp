@@ -7,6 +7,7 @@
 #include "UpdateModel.h"
 
 // Qt includes
+#include <functional>
 #include <QFont>
 #include <QTimer>
 #include "libdiscover_debug.h"
@@ -20,6 +21,32 @@
 #include <resources/AbstractResource.h>
 #include <resources/ResourcesUpdatesModel.h>
 #include <resources/ResourcesModel.h>
+#include <utils.h>
+
+static int sectionOrder(AbstractResource::Type type)
+{
+    switch (type) {
+    case AbstractResource::Application:
+        return 0;
+    case AbstractResource::Addon:
+        return 1;
+    case AbstractResource::Technical:
+        return 2;
+    }
+    Q_UNREACHABLE();
+}
+
+static bool itemLessThan(UpdateItem* a, UpdateItem* b)
+{
+    const int sectionA = sectionOrder(a->resource()->type()), sectionB = sectionOrder(b->resource()->type());
+    if (sectionA != sectionB)
+        return sectionA < sectionB;
+
+    const QString nameA = a->name(), nameB = b->name();
+    if (nameA != nameB)
+        return nameA < nameB;
+    return std::less<UpdateItem*>()(a, b);
+}
 
 UpdateModel::UpdateModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -28,6 +55,7 @@ UpdateModel::UpdateModel(QObject *parent)
 {
     connect(ResourcesModel::global(), &ResourcesModel::fetchingChanged, this, &UpdateModel::activityChanged);
     connect(ResourcesModel::global(), &ResourcesModel::updatesCountChanged, this, &UpdateModel::activityChanged);
+    connect(ResourcesModel::global()->updatesChecker(), &UpdatesChecker::backendChecked, this, &UpdateModel::activityChanged);
     connect(ResourcesModel::global(), &ResourcesModel::resourceDataChanged, this, &UpdateModel::resourceDataChanged);
     connect(this, &UpdateModel::toUpdateChanged, this, &UpdateModel::updateSizeChanged);
 
@@ -77,11 +105,22 @@ void UpdateModel::updateResourceResult(AbstractResource* res)
     UpdateItem* item = itemFromResource(res);
     if (!item)
         return;
-    const auto residx = m_updateItems.indexOf(item);
+    const auto residx = indexFromItem(item).row();
     if (residx < 0)
         return;
-    beginRemoveRows({}, residx, residx);
-    m_updateItems.removeAt(residx);
+    m_resources.removeAll(res);
+    removeItems(residx, residx);
+}
+
+void UpdateModel::removeItems(int first, int last)
+{
+    beginRemoveRows({}, first, last);
+    for (int i = first; i <= last; ++i) {
+        UpdateItem* item = m_updateItems[i];
+        m_itemsByResource.remove(item->resource());
+        delete item;
+    }
+    m_updateItems.remove(first, last - first + 1);
     endRemoveRows();
 }
 
@@ -107,6 +146,9 @@ void UpdateModel::activityChanged()
             for (auto item : qAsConst(m_updateItems)) {
                 item->setProgress(0);
             }
+            if (!m_updateItems.isEmpty()) {
+                Q_EMIT dataChanged(index(0, 0), index(m_updateItems.count() - 1, 0), { ResourceProgressRole, SectionResourceProgressRole });
+            }
         } else
             setResources(m_updates->toUpdate());
     }
@@ -243,37 +285,60 @@ void UpdateModel::setResources(const QList<AbstractResource*>& resources)
         return;
     }
     m_resources = resources;
+    const auto newResources = kToSet(resources);
 
-    beginResetModel();
-    qDeleteAll(m_updateItems);
-    m_updateItems.clear();
+    // Items that stay keep their progress and changelog, only what's gone is
+    // removed, one range of rows at a time
+    for (int last = m_updateItems.count() - 1; last >= 0; ) {
+        if (newResources.contains(m_updateItems.at(last)->resource())) {
+            --last;
+            continue;
+        }
 
-    QVector<UpdateItem*> appItems, systemItems, addonItems;
-    foreach (AbstractResource* res, resources) {
-        connect(res, &AbstractResource::changelogFetched, this, &UpdateModel::integrateChangelog, Qt::UniqueConnection);
+        int first = last;
+        while (first > 0 && !newResources.contains(m_updateItems.at(first - 1)->resource()))
+            --first;
+        removeItems(first, last);
+        last = first - 1;
+    }
 
-        UpdateItem *updateItem = new UpdateItem(res);
+    QVector<UpdateItem*> added;
+    for (AbstractResource* res : resources) {
+        if (m_itemsByResource.contains(res))
+            continue;
 
-        switch (res->type()) {
-        case AbstractResource::Technical:
-            systemItems += updateItem;
-            break;
-        case AbstractResource::Application:
-            appItems += updateItem;
-            break;
-        case AbstractResource::Addon:
-            addonItems += updateItem;
-            break;
+        connect(res, &AbstractResource::changelogFetched, this, &UpdateModel::integrateChangelog, Qt::UniqueConnection);
+        UpdateItem *updateItem = new UpdateItem(res);
+        m_itemsByResource.insert(res, updateItem);
+        added += updateItem;
+    }
+    std::sort(added.begin(), added.end(), itemLessThan);
+
+    // Merge them in, inserting every run of new items that goes before the same row at once
+    int row = 0;
+    for (int i = 0, count = added.count(); i < count; ) {
+        row = std::lower_bound(m_updateItems.constBegin() + row, m_updateItems.constEnd(), added.at(i), itemLessThan) - m_updateItems.constBegin();
+        int next = i + 1;
+        if (row < m_updateItems.count()) {
+            while (next < count && itemLessThan(added.at(next), m_updateItems.at(row)))
+                ++next;
+        } else {
+            next = count;
         }
+
+        beginInsertRows({}, row, row + next - i - 1);
+        m_updateItems.insert(row, next - i, nullptr);
+        std::copy(added.constBegin() + i, added.constBegin() + next, m_updateItems.begin() + row);
+        endInsertRows();
+
+        row += next - i;
+        i = next;
+    }
+
+    // Which ones are marked depends on the resources that are set
+    if (!m_updateItems.isEmpty()) {
+        Q_EMIT dataChanged(index(0, 0), index(m_updateItems.count() - 1, 0), { Qt::CheckStateRole });
     }
-    const auto sortUpdateItems = [](UpdateItem *a, UpdateItem *b) {
-        return a->name() < b->name();
-    };
-    std::sort(appItems.begin(), appItems.end(), sortUpdateItems);
-    std::sort(systemItems.begin(), systemItems.end(), sortUpdateItems);
-    std::sort(addonItems.begin(), addonItems.end(), sortUpdateItems);
-    m_updateItems = (QVector<UpdateItem*>() << appItems << addonItems << systemItems);
-    endResetModel();
 
     Q_EMIT hasUpdatesChanged(!resources.isEmpty());
     Q_EMIT toUpdateChanged();
@@ -319,13 +384,9 @@ int UpdateModel::totalUpdatesCount() const
     return ret;
 }
 
-UpdateItem * UpdateModel::itemFromResource(AbstractResource* res)
+UpdateItem * UpdateModel::itemFromResource(AbstractResource* res) const
 {
-    foreach (UpdateItem* item, m_updateItems) {
-        if (item->app() == res)
-            return item;
-    }
-    return nullptr;
+    return m_itemsByResource.value(res);
 }
 
 QString UpdateModel::updateSize() const
@@ -335,7 +396,14 @@ QString UpdateModel::updateSize() const
 
 QModelIndex UpdateModel::indexFromItem(UpdateItem* item) const
 {
-    return index(m_updateItems.indexOf(item), 0, {});
+    auto it = std::lower_bound(m_updateItems.constBegin(), m_updateItems.constEnd(), item, itemLessThan);
+    if (it == m_updateItems.constEnd() || *it != item) {
+        // The name changed after it was sorted
+        it = std::find(m_updateItems.constBegin(), m_updateItems.constEnd(), item);
+        if (it == m_updateItems.constEnd())
+            return {};
+    }
+    return index(it - m_updateItems.constBegin(), 0, {});
 }
 
 UpdateItem * UpdateModel::itemFromIndex(const QModelIndex& index) const
@@ -84,13 +84,16 @@ private:
     void resourceDataChanged(AbstractResource* res, const QVector<QByteArray> &properties);
     void integrateChangelog(const QString &changelog);
     QModelIndex indexFromItem(UpdateItem* item) const;
-    UpdateItem* itemFromResource(AbstractResource* res);
+    UpdateItem* itemFromResource(AbstractResource* res) const;
+    void removeItems(int first, int last);
     void resourceHasProgressed(AbstractResource* res, qreal progress, AbstractBackendUpdater::State state);
     void activityChanged();
     void updateResourceResult(AbstractResource* res);
 
     QTimer* const m_updateSizeTimer;
+    // Sorted by section and then by name
     QVector<UpdateItem*> m_updateItems;
+    QHash<AbstractResource*, UpdateItem*> m_itemsByResource;
     ResourcesUpdatesModel* m_updates;
     QList<AbstractResource*> m_resources;
 };
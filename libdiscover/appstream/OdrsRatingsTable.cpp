@@ -0,0 +1,183 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "OdrsRatingsTable.h"
+#include <ReviewsBackend/Rating.h>
+#include "libdiscover_debug.h"
+
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+static const char s_magic[8] = { 'O', 'D', 'R', 'S', 'R', 'A', 'T', '1' };
+static const quint32 s_version = 1;
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 count;
+};
+
+Q_STATIC_ASSERT(sizeof(Header) == 16);
+Q_STATIC_ASSERT(sizeof(OdrsRatingsTable::Entry) == 48);
+
+static int compareId(const char *a, quint32 aLength, const QByteArray &b)
+{
+    const int cmp = std::memcmp(a, b.constData(), qMin<quint32>(aLength, b.size()));
+    if (cmp != 0)
+        return cmp;
+    return aLength < quint32(b.size()) ? -1 : (aLength > quint32(b.size()) ? 1 : 0);
+}
+
+OdrsRatingsTable::OdrsRatingsTable() = default;
+
+OdrsRatingsTable::~OdrsRatingsTable()
+{
+    close();
+}
+
+bool OdrsRatingsTable::build(const QJsonObject &ratings, const QString &path)
+{
+    struct Item {
+        QByteArray id;
+        Entry entry;
+    };
+
+    QVector<Item> items;
+    items.reserve(ratings.size());
+    for (auto it = ratings.constBegin(); it != ratings.constEnd(); ++it) {
+        const QJsonObject appJsonObject = it.value().toObject();
+
+        int ratingMap[] = { appJsonObject.value(QLatin1String("star0")).toInt(),
+                            appJsonObject.value(QLatin1String("star1")).toInt(),
+                            appJsonObject.value(QLatin1String("star2")).toInt(),
+                            appJsonObject.value(QLatin1String("star3")).toInt(),
+                            appJsonObject.value(QLatin1String("star4")).toInt(),
+                            appJsonObject.value(QLatin1String("star5")).toInt()
+                          };
+
+        Item item;
+        item.id = it.key().toUtf8();
+        item.entry = {};
+        item.entry.total = appJsonObject.value(QLatin1String("total")).toInt();
+        std::copy(ratingMap, ratingMap + 6, item.entry.stars);
+        item.entry.sortableRating = Rating::computeSortableRating(ratingMap);
+        items.append(item);
+    }
+
+    // QJsonObject keys are already sorted, but by QString order; lookups compare bytes
+    std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) { return a.id < b.id; });
+
+    QByteArray strings;
+    for (auto &item : items) {
+        item.entry.idOffset = strings.size();
+        item.entry.idLength = item.id.size();
+        strings += item.id;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBDISCOVER_LOG) << "could not write the ratings table" << path << file.errorString();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = s_version;
+    header.count = items.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &item : qAsConst(items)) {
+        file.write(reinterpret_cast<const char *>(&item.entry), sizeof(Entry));
+    }
+    file.write(strings);
+    return file.commit();
+}
+
+bool OdrsRatingsTable::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    const uchar *data = fileSize >= qint64(sizeof(Header)) ? m_file.map(0, fileSize) : nullptr;
+    if (!data) {
+        qCWarning(LIBDISCOVER_LOG) << "could not map the ratings table" << path;
+        m_file.close();
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(data);
+    const qint64 stringsStart = qint64(sizeof(Header)) + qint64(header->count) * qint64(sizeof(Entry));
+    if (std::memcmp(header->magic, s_magic, sizeof(s_magic)) != 0 || header->version != s_version || stringsStart > fileSize) {
+        qCWarning(LIBDISCOVER_LOG) << "invalid ratings table" << path;
+        m_file.close();
+        return false;
+    }
+
+    const Entry *entries = reinterpret_cast<const Entry *>(data + sizeof(Header));
+    const quint64 stringsSize = fileSize - stringsStart;
+    for (quint32 i = 0; i < header->count; ++i) {
+        if (quint64(entries[i].idOffset) + entries[i].idLength > stringsSize) {
+            qCWarning(LIBDISCOVER_LOG) << "corrupt ratings table" << path;
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_entries = entries;
+    m_strings = reinterpret_cast<const char *>(data + stringsStart);
+    m_count = header->count;
+    return true;
+}
+
+void OdrsRatingsTable::close()
+{
+    // closing the file unmaps it
+    m_file.close();
+    m_entries = nullptr;
+    m_strings = nullptr;
+    m_count = 0;
+}
+
+const OdrsRatingsTable::Entry *OdrsRatingsTable::find(const QByteArray &id) const
+{
+    const Entry *begin = m_entries;
+    const Entry *end = m_entries + m_count;
+    const auto it = std::lower_bound(begin, end, id, [this](const Entry &entry, const QByteArray &id) {
+        return compareId(m_strings + entry.idOffset, entry.idLength, id) < 0;
+    });
+    if (it == end || compareId(m_strings + it->idOffset, it->idLength, id) != 0) {
+        return nullptr;
+    }
+    return it;
+}
+
+bool OdrsRatingsTable::contains(const QString &appstreamId) const
+{
+    return isOpen() && find(appstreamId.toUtf8());
+}
+
+Rating *OdrsRatingsTable::rating(const QString &appstreamId) const
+{
+    if (!isOpen()) {
+        return nullptr;
+    }
+
+    const Entry *entry = find(appstreamId.toUtf8());
+    if (!entry) {
+        return nullptr;
+    }
+
+    int ratingMap[6];
+    std::copy(entry->stars, entry->stars + 6, ratingMap);
+    return new Rating(appstreamId, entry->total, ratingMap, entry->sortableRating);
+}
@@ -0,0 +1,64 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef ODRSRATINGSTABLE_H
+#define ODRSRATINGSTABLE_H
+
+#include <QFile>
+#include <QString>
+
+class QJsonObject;
+class Rating;
+
+/**
+ * Read-only view over the ODRS ratings, stored as a sorted binary table.
+ *
+ * The ratings JSON is converted once with build() and the resulting file is
+ * mapped into memory by open(), so looking up a rating doesn't require
+ * having the whole document parsed into objects.
+ *
+ * The table is a local cache and uses the host's byte order.
+ */
+class OdrsRatingsTable
+{
+public:
+    OdrsRatingsTable();
+    ~OdrsRatingsTable();
+
+    /// Converts the ODRS @p ratings document into a table stored at @p path
+    static bool build(const QJsonObject &ratings, const QString &path);
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_entries; }
+    quint32 size() const { return m_count; }
+
+    bool contains(const QString &appstreamId) const;
+
+    /// @returns a new Rating for @p appstreamId or nullptr if there's none, ownership is passed to the caller
+    Rating *rating(const QString &appstreamId) const;
+
+    struct Entry {
+        quint32 idOffset;
+        quint32 idLength;
+        quint32 total;
+        quint32 stars[6];
+        quint32 padding;
+        double sortableRating;
+    };
+
+private:
+    Q_DISABLE_COPY(OdrsRatingsTable)
+
+    const Entry *find(const QByteArray &id) const;
+
+    QFile m_file;
+    const Entry *m_entries = nullptr;
+    const char *m_strings = nullptr;
+    quint32 m_count = 0;
+};
+
+#endif // ODRSRATINGSTABLE_H
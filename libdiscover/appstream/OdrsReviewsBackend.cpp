@@ -29,14 +29,26 @@
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QStandardPaths>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QtConcurrentRun>
 
 // #define APIURL "http://127.0.0.1:5000/1.0/reviews/api"
 #define APIURL "https://odrs.gnome.org/1.0/reviews/api"
 
+// Reviews are considered up to date for a day, same as the ratings
+static const int s_reviewsTtl = 60 * 60 * 24;
+// How many reviews requests can be prefetching at once and how many can be waiting for it
+static const int s_maxPrefetching = 2;
+static const int s_maxPrefetchQueue = 16;
+
 OdrsReviewsBackend::OdrsReviewsBackend()
     : AbstractReviewsBackend(nullptr)
     , m_isFetching(false)
+    , m_reviewsCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/odrs-reviews"), s_reviewsTtl)
 {
+    m_ratingsReady.reportStarted();
+
     bool fetchRatings = false;
     const QUrl ratingsUrl(QStringLiteral(APIURL "/ratings"));
     const QUrl fileUrl = QUrl::fromLocalFile(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/ratings/ratings"));
@@ -66,17 +78,21 @@ OdrsReviewsBackend::OdrsReviewsBackend()
 
 OdrsReviewsBackend::~OdrsReviewsBackend() noexcept
 {
+    if (!m_ratingsReady.isFinished()) {
+        m_ratingsReady.reportCanceled();
+        m_ratingsReady.reportFinished();
+    }
     qDeleteAll(m_ratings);
 }
 
 void OdrsReviewsBackend::ratingsFetched(KJob *job)
 {
-    m_isFetching = false;
+    updateFetching();
     if (job->error()) {
+        // Use whatever we have from last time, if anything
         qCWarning(LIBDISCOVER_LOG) << "Failed to fetch ratings " << job->errorString();
-    } else {
-        parseRatings();
     }
+    parseRatings();
 }
 
 static QString osName()
@@ -101,11 +117,125 @@ static QString userHash()
     return QString::fromUtf8(QCryptographicHash::hash(salted.toUtf8(), QCryptographicHash::Sha1).toHex());
 }
 
+QString OdrsReviewsBackend::reviewsCacheKey(AbstractResource *app) const
+{
+    return OdrsReviewsCache::key(app->appstreamId(), QLocale::system().name(), app->isInstalled() ? app->installedVersion() : app->availableVersion());
+}
+
 void OdrsReviewsBackend::fetchReviews(AbstractResource *app, int page)
 {
+    // All the reviews come in the first page
     Q_UNUSED(page)
-    m_isFetching = true;
 
+    const QString key = reviewsCacheKey(app);
+    const QByteArray cached = m_reviewsCache.find(key);
+    if (!cached.isNull()) {
+        // Callers expect the reviews to come later, like when they're fetched
+        QPointer<AbstractResource> resource = app;
+        QTimer::singleShot(0, this, [this, resource, cached] {
+            if (resource) {
+                parseReviews(QJsonDocument::fromJson(cached), resource);
+            }
+        });
+        return;
+    }
+
+    auto it = m_pendingReviews.find(key);
+    if (it == m_pendingReviews.end()) {
+        m_pendingReviews.insert(key, { app });
+        lookUpReviews(app, key);
+    } else {
+        // Already being prefetched, just wait for it
+        it->append(app);
+    }
+    updateFetching();
+}
+
+void OdrsReviewsBackend::prefetchReviews(AbstractResource *app)
+{
+    if (!isResourceSupported(app)) {
+        return;
+    }
+
+    m_prefetchQueue.append(app);
+    // Only the latest presses are worth it, the user moved on from the oldest ones
+    if (m_prefetchQueue.size() > s_maxPrefetchQueue) {
+        m_prefetchQueue.remove(0, m_prefetchQueue.size() - s_maxPrefetchQueue);
+    }
+    startPrefetching();
+}
+
+void OdrsReviewsBackend::startPrefetching()
+{
+    while (m_prefetching.size() < s_maxPrefetching && !m_prefetchQueue.isEmpty()) {
+        QPointer<AbstractResource> app = m_prefetchQueue.takeLast();
+        if (!app) {
+            continue;
+        }
+
+        const QString key = reviewsCacheKey(app);
+        if (m_pendingReviews.contains(key) || !m_reviewsCache.find(key).isNull()) {
+            continue;
+        }
+
+        m_pendingReviews.insert(key, {});
+        m_prefetching.insert(key);
+        lookUpReviews(app, key);
+    }
+}
+
+void OdrsReviewsBackend::updateFetching()
+{
+    m_isFetching = false;
+    for (const auto &waiting : qAsConst(m_pendingReviews)) {
+        if (!waiting.isEmpty()) {
+            m_isFetching = true;
+            break;
+        }
+    }
+}
+
+void OdrsReviewsBackend::lookUpReviews(AbstractResource *app, const QString &key)
+{
+    // Only ask ODRS if there's nothing valid on disk, which is read on a worker
+    QPointer<AbstractResource> resource = app;
+    auto fw = new QFutureWatcher<OdrsReviewsCache::Entry>(this);
+    connect(fw, &QFutureWatcher<OdrsReviewsCache::Entry>::finished, this, [this, fw, resource, key] {
+        fw->deleteLater();
+        const OdrsReviewsCache::Entry entry = fw->result();
+        if (entry.data.isNull() && resource) {
+            requestReviews(resource, key);
+            return;
+        }
+
+        m_reviewsCache.insert(key, entry);
+        const auto waiting = takePendingReviews(key);
+        if (entry.data.isNull()) {
+            return;
+        }
+
+        const QJsonDocument document = QJsonDocument::fromJson(entry.data);
+        for (const auto &res : waiting) {
+            if (res) {
+                parseReviews(document, res);
+            }
+        }
+    });
+    fw->setFuture(m_reviewsCache.read(key));
+}
+
+QVector<QPointer<AbstractResource>> OdrsReviewsBackend::takePendingReviews(const QString &key)
+{
+    const auto waiting = m_pendingReviews.take(key);
+    updateFetching();
+    if (m_prefetching.remove(key)) {
+        startPrefetching();
+    }
+    return waiting;
+}
+
+void OdrsReviewsBackend::requestReviews(AbstractResource *app, const QString &key)
+{
     const QJsonDocument document(QJsonObject{
         {QStringLiteral("app_id"), app->appstreamId()},
         {QStringLiteral("distro"), osName()},
@@ -119,8 +249,8 @@ void OdrsReviewsBackend::fetchReviews(AbstractResource *app, int page)
     QNetworkRequest request(QUrl(QStringLiteral(APIURL "/fetch")));
     request.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json; charset=utf-8"));
     request.setHeader(QNetworkRequest::ContentLengthHeader, json.size());
-    // Store reference to the app for which we request reviews
-    request.setOriginatingObject(app);
+    // Store the cache key, the resources waiting for it are in m_pendingReviews
+    request.setAttribute(QNetworkRequest::User, key);
 
     auto reply = nam()->post(request, json);
     connect(reply, &QNetworkReply::finished, this, &OdrsReviewsBackend::reviewsFetched);
@@ -132,17 +262,26 @@ void OdrsReviewsBackend::reviewsFetched()
     QScopedPointer<QNetworkReply, QScopedPointerDeleteLater> replyPtr(reply);
     const QByteArray data = reply->readAll();
     const auto networkError = reply->error();
+
+    const QString key = reply->request().attribute(QNetworkRequest::User).toString();
+    const auto waiting = takePendingReviews(key);
+
     if (networkError != QNetworkReply::NoError) {
         qCWarning(LIBDISCOVER_LOG) << "error fetching reviews:" << reply->errorString() << data;
-        Q_EMIT error(i18n("Error while fetching reviews: %1", reply->errorString()));
-        m_isFetching = false;
+        if (!waiting.isEmpty()) {
+            Q_EMIT error(i18n("Error while fetching reviews: %1", reply->errorString()));
+        }
         return;
     }
 
+    m_reviewsCache.insert(key, data);
+
     const QJsonDocument document = QJsonDocument::fromJson(data);
-    AbstractResource *resource = qobject_cast<AbstractResource*>(reply->request().originatingObject());
-    Q_ASSERT(resource);
-    parseReviews(document, resource);
+    for (const auto &resource : waiting) {
+        if (resource) {
+            parseReviews(document, resource);
+        }
+    }
 }
 
 Rating * OdrsReviewsBackend::ratingForApplication(AbstractResource *app) const
@@ -151,7 +290,12 @@ Rating * OdrsReviewsBackend::ratingForApplication(AbstractResource *app) const
         return nullptr;
     }
 
-    return m_ratings[app->appstreamId()];
+    const QString id = app->appstreamId();
+    auto it = m_ratings.constFind(id);
+    if (it == m_ratings.constEnd()) {
+        it = m_ratings.insert(id, m_ratingsTable.rating(id));
+    }
+    return *it;
 }
 
 void OdrsReviewsBackend::submitUsefulness(Review *review, bool useful)
@@ -230,6 +374,7 @@ void OdrsReviewsBackend::reviewSubmitted(QNetworkReply *reply)
         Q_ASSERT(resource);
         qCWarning(LIBDISCOVER_LOG) << "Review submitted" << resource;
         if (resource) {
+            m_reviewsCache.remove(reviewsCacheKey(resource));
             const QJsonDocument document({resource->getMetadata(QStringLiteral("ODRS::review_map")).toObject()});
             parseReviews(document, resource);
         } else {
@@ -242,37 +387,84 @@ void OdrsReviewsBackend::reviewSubmitted(QNetworkReply *reply)
     reply->deleteLater();
 }
 
+static QString ratingsPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/ratings/ratings");
+}
+
+static QString ratingsTablePath()
+{
+    return ratingsPath() + QStringLiteral(".table");
+}
+
+// Makes sure the ratings table is up to date with the downloaded ratings, runs on a worker
+static bool buildRatingsTable(const QString &ratingsPath, const QString &tablePath)
+{
+    // The JSON document is only parsed when it changed, otherwise the table it was converted to is used as is
+    const QFileInfo ratingsInfo(ratingsPath);
+    const QFileInfo tableInfo(tablePath);
+    if (tableInfo.exists() && tableInfo.lastModified() >= ratingsInfo.lastModified()) {
+        return true;
+    }
+
+    QFile ratingsDocument(ratingsPath);
+    if (!ratingsDocument.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QJsonDocument jsonDocument = QJsonDocument::fromJson(ratingsDocument.readAll());
+    return OdrsRatingsTable::build(jsonDocument.object(), tablePath);
+}
+
 void OdrsReviewsBackend::parseRatings()
 {
-    QFile ratingsDocument(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/ratings/ratings"));
-    if (ratingsDocument.open(QIODevice::ReadOnly)) {
-        QJsonDocument jsonDocument = QJsonDocument::fromJson(ratingsDocument.readAll());
-        const QJsonObject jsonObject = jsonDocument.object();
-        m_ratings.reserve(jsonObject.size());
-        for (auto it = jsonObject.begin(); it != jsonObject.end(); it++) {
-            QJsonObject appJsonObject = it.value().toObject();
-
-            const int ratingCount =  appJsonObject.value(QLatin1String("total")).toInt();
-            int ratingMap[] = { appJsonObject.value(QLatin1String("star0")).toInt(),
-                                appJsonObject.value(QLatin1String("star1")).toInt(),
-                                appJsonObject.value(QLatin1String("star2")).toInt(),
-                                appJsonObject.value(QLatin1String("star3")).toInt(),
-                                appJsonObject.value(QLatin1String("star4")).toInt(),
-                                appJsonObject.value(QLatin1String("star5")).toInt()
-                              };
-
-            Rating *rating = new Rating(it.key(), ratingCount, ratingMap);
-            m_ratings.insert(it.key(), rating);
-        }
-        ratingsDocument.close();
+    auto fw = new QFutureWatcher<bool>(this);
+    connect(fw, &QFutureWatcher<bool>::finished, this, [this, fw] {
+        ratingsParsed(fw->result());
+        fw->deleteLater();
+    });
+    fw->setFuture(QtConcurrent::run(&buildRatingsTable, ratingsPath(), ratingsTablePath()));
+}
+
+void OdrsReviewsBackend::ratingsParsed(bool built)
+{
+    const bool opened = built && m_ratingsTable.open(ratingsTablePath());
+    if (!opened) {
+        qCWarning(LIBDISCOVER_LOG) << "Could not load the ratings from" << ratingsPath();
+    }
 
-        Q_EMIT ratingsReady();
+    if (!m_ratingsReady.isFinished()) {
+        m_ratingsReady.reportFinished();
     }
+
+    if (!opened) {
+        return;
+    }
+
+    // Ratings that were handed out are held by resources and QML, so they're
+    // updated in place. One that isn't in the new table keeps its last value.
+    m_pendingRatings.clear();
+    for (auto it = m_ratings.begin(), itEnd = m_ratings.end(); it != itEnd; ++it) {
+        m_pendingRatings.insert(it.key());
+
+        QScopedPointer<Rating> updated(m_ratingsTable.rating(it.key()));
+        if (!*it) {
+            *it = updated.take();
+        } else if (updated) {
+            **it = *updated;
+        }
+    }
+    Q_EMIT ratingsReady();
+    m_pendingRatings.clear();
+}
+
+QFuture<void> OdrsReviewsBackend::ratingsFuture() const
+{
+    return m_ratingsReady.future();
 }
 
 void OdrsReviewsBackend::parseReviews(const QJsonDocument &document, AbstractResource *resource)
 {
-    m_isFetching = false;
     Q_ASSERT(resource);
     if (!resource) {
         return;
@@ -318,8 +510,15 @@ bool OdrsReviewsBackend::isResourceSupported(AbstractResource* res) const
 void OdrsReviewsBackend::emitRatingFetched(AbstractResourcesBackend* b, const QList<AbstractResource *>& resources) const
 {
     b->emitRatingsReady();
+
+    // Only resources whose rating was looked at can have anything bound to it, the rest will
+    // get their rating when they are asked for it
+    if (m_pendingRatings.isEmpty()) {
+        return;
+    }
     foreach (AbstractResource* res, resources) {
-        if (m_ratings.contains(res->appstreamId())) {
+        const QString id = res->appstreamId();
+        if (m_pendingRatings.contains(id) && m_ratingsTable.contains(id)) {
             Q_EMIT res->ratingFetched();
         }
     }
@@ -10,10 +10,15 @@
 
 #include <ReviewsBackend/AbstractReviewsBackend.h>
 #include <ReviewsBackend/ReviewsModel.h>
+#include "OdrsRatingsTable.h"
+#include "OdrsReviewsCache.h"
 
 #include <QJsonDocument>
 #include <QNetworkReply>
 #include <QMap>
+#include <QSet>
+#include <QFutureInterface>
+#include <QPointer>
 
 class KJob;
 class AbstractResourcesBackend;
@@ -32,11 +37,13 @@ public:
     void registerAndLogin() override {}
 
     Rating * ratingForApplication(AbstractResource *app) const override;
+    QFuture<void> ratingsFuture() const override;
     bool hasCredentials() const override {
         return false;
     }
     void deleteReview(Review *) override {}
     void fetchReviews(AbstractResource *app, int page = 1) override;
+    void prefetchReviews(AbstractResource *app) override;
     bool isFetching() const override {
         return m_isFetching;
     }
@@ -58,10 +65,29 @@ Q_SIGNALS:
 private:
     QNetworkAccessManager* nam();
     void parseRatings();
+    void ratingsParsed(bool built);
     void parseReviews(const QJsonDocument &document, AbstractResource *resource);
+    QString reviewsCacheKey(AbstractResource *app) const;
+    void lookUpReviews(AbstractResource *app, const QString &key);
+    void requestReviews(AbstractResource *app, const QString &key);
+    QVector<QPointer<AbstractResource>> takePendingReviews(const QString &key);
+    void startPrefetching();
+    void updateFetching();
 
-    QHash<QString, Rating*> m_ratings;
+    OdrsRatingsTable m_ratingsTable;
+    // Ratings are created from m_ratingsTable as they are requested, misses are cached as nullptr.
+    // They are handed out as pointers, so they live as long as the backend and are updated in place.
+    mutable QHash<QString, Rating*> m_ratings;
+    // Ids that were asked for before the ratings were parsed, they get notified on ratingsReady
+    QSet<QString> m_pendingRatings;
+    mutable QFutureInterface<void> m_ratingsReady;
     bool m_isFetching;
+    OdrsReviewsCache m_reviewsCache;
+    // Reviews requests in flight, with the resources that are waiting for them.
+    // Prefetched reviews have nobody waiting for them until fetchReviews() is called.
+    QHash<QString, QVector<QPointer<AbstractResource>>> m_pendingReviews;
+    QVector<QPointer<AbstractResource>> m_prefetchQueue;
+    QSet<QString> m_prefetching;
     CachedNetworkAccessManager* m_delayedNam = nullptr;
 };
 
@@ -0,0 +1,108 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "OdrsReviewsCache.h"
+#include "libdiscover_debug.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrentRun>
+
+// Costs are in bytes, keep at most this much in memory
+static const int s_memoryBudget = 4 * 1024 * 1024;
+
+OdrsReviewsCache::OdrsReviewsCache(const QString &directory, int ttl)
+    : m_entries(s_memoryBudget)
+    , m_directory(directory)
+    , m_ttl(ttl)
+{
+    QDir().mkpath(m_directory);
+    QtConcurrent::run(&OdrsReviewsCache::removeExpired, m_directory, m_ttl);
+}
+
+QString OdrsReviewsCache::key(const QString &appstreamId, const QString &locale, const QString &version)
+{
+    return appstreamId + QLatin1Char('|') + locale + QLatin1Char('|') + version;
+}
+
+QString OdrsReviewsCache::filePath(const QString &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+bool OdrsReviewsCache::isValid(const QDateTime &fetched, int ttl)
+{
+    return fetched.secsTo(QDateTime::currentDateTimeUtc()) < ttl;
+}
+
+QByteArray OdrsReviewsCache::find(const QString &key)
+{
+    if (Entry *entry = m_entries.object(key)) {
+        if (isValid(entry->fetched, m_ttl)) {
+            return entry->data;
+        }
+        m_entries.remove(key);
+    }
+    return {};
+}
+
+QFuture<OdrsReviewsCache::Entry> OdrsReviewsCache::read(const QString &key) const
+{
+    return QtConcurrent::run(&OdrsReviewsCache::readFile, filePath(key), m_ttl);
+}
+
+OdrsReviewsCache::Entry OdrsReviewsCache::readFile(const QString &path, int ttl)
+{
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return {};
+    }
+
+    const QDateTime fetched = info.lastModified().toUTC();
+    QFile file(path);
+    if (!isValid(fetched, ttl) || !file.open(QIODevice::ReadOnly)) {
+        QFile::remove(path);
+        return {};
+    }
+
+    return { file.readAll(), fetched };
+}
+
+void OdrsReviewsCache::removeExpired(const QString &directory, int ttl)
+{
+    const auto files = QDir(directory).entryInfoList(QDir::Files);
+    for (const QFileInfo &info : files) {
+        if (!isValid(info.lastModified().toUTC(), ttl)) {
+            QFile::remove(info.absoluteFilePath());
+        }
+    }
+}
+
+void OdrsReviewsCache::insert(const QString &key, const Entry &entry)
+{
+    if (!entry.data.isNull()) {
+        m_entries.insert(key, new Entry(entry), entry.data.size());
+    }
+}
+
+void OdrsReviewsCache::insert(const QString &key, const QByteArray &data)
+{
+    insert(key, Entry { data, QDateTime::currentDateTimeUtc() });
+
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qCWarning(LIBDISCOVER_LOG) << "could not store reviews" << key << file.errorString();
+    }
+}
+
+void OdrsReviewsCache::remove(const QString &key)
+{
+    m_entries.remove(key);
+    QFile::remove(filePath(key));
+}
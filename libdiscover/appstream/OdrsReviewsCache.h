@@ -0,0 +1,63 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef ODRSREVIEWSCACHE_H
+#define ODRSREVIEWSCACHE_H
+
+#include <QCache>
+#include <QDateTime>
+#include <QFuture>
+#include <QString>
+
+/**
+ * Keeps the ODRS review responses around, both in memory and on disk.
+ *
+ * ODRS is queried with POST requests which don't go through the network
+ * cache, so this makes sure revisiting an application doesn't download its
+ * reviews again until @p ttl seconds have passed.
+ */
+class OdrsReviewsCache
+{
+public:
+    struct Entry {
+        QByteArray data;
+        QDateTime fetched;
+    };
+
+    OdrsReviewsCache(const QString &directory, int ttl);
+
+    /// ODRS answers with every review at once, so there's one entry per application version and locale
+    static QString key(const QString &appstreamId, const QString &locale, const QString &version);
+
+    /// @returns the response kept in memory for @p key, or a null QByteArray if there's no valid one
+    QByteArray find(const QString &key);
+
+    /**
+     * Reads the response stored on disk for @p key on a worker, the data is null if there's no valid one.
+     *
+     * Doesn't touch what's in memory, pass the result to insert() once it's done.
+     */
+    QFuture<Entry> read(const QString &key) const;
+
+    /// Keeps a response that was just fetched, in memory and on disk
+    void insert(const QString &key, const QByteArray &data);
+    /// Keeps a response that was read(), in memory only
+    void insert(const QString &key, const Entry &entry);
+    void remove(const QString &key);
+
+private:
+    QString filePath(const QString &key) const;
+    static Entry readFile(const QString &path, int ttl);
+    /// Files are named after the application version, the ones of older versions are never read again
+    static void removeExpired(const QString &directory, int ttl);
+    static bool isValid(const QDateTime &fetched, int ttl);
+
+    QCache<QString, Entry> m_entries;
+    const QString m_directory;
+    const int m_ttl;
+};
+
+#endif // ODRSREVIEWSCACHE_H
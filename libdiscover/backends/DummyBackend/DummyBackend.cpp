@@ -72,6 +72,7 @@ void DummyBackend::populate(const QString& n)
         m_resources.insert(name, res);
         connect(res, &DummyResource::stateChanged, this, &DummyBackend::updatesCountChanged);
     }
+    emit updatesCountChanged();
 }
 
 void DummyBackend::toggleFetching()
@@ -24,6 +24,7 @@ public:
     AbstractBackendUpdater* backendUpdater() const override;
     AbstractReviewsBackend* reviewsBackend() const override;
     ResultsStream* search(const AbstractResourcesBackend::Filters & search) override;
+    bool isSearchPrefixMonotonic() const override { return true; }
     ResultsStream * findResourceByPackageName(const QUrl& search);
     QHash<QString, DummyResource*> resources() const {
         return m_resources;
@@ -42,11 +43,13 @@ public:
     QString displayName() const override;
     bool hasApplications() const override;
 
+    /// Adds startElements applications, addons and technical resources, benchmarks use it to scale the backend
+    Q_INVOKABLE void populate(const QString& name);
+
 public Q_SLOTS:
     void toggleFetching();
 
 private:
-    void populate(const QString& name);
 
     QHash<QString, DummyResource*> m_resources;
     StandardBackendUpdater* m_updater;
@@ -0,0 +1,285 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <resources/ResourcesModel.h>
+#include <resources/ResourcesProxyModel.h>
+#include <resources/AbstractResource.h>
+#include <UpdateModel/UpdateModel.h>
+#include <Category/Category.h>
+#include <Category/CategoryModel.h>
+#include "DiscoverBackendsFactory.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+#include <QtTest>
+#include <algorithm>
+#include <functional>
+
+// Longer than any of the benchmarks should take, a stream or model that isn't done by then hung
+static const int s_timeout = 60000;
+
+/**
+ * Measures how the models scale with the amount of resources.
+ *
+ * The dummy backend is grown to every size in DISCOVER_BENCHMARK_SIZES (10000
+ * and 50000 resources by default, up to 200000 is reasonable) and each benchmark
+ * is run DISCOVER_BENCHMARK_ITERATIONS times on it. The timings are written as
+ * JSON to DISCOVER_BENCHMARK_OUTPUT, dummybenchmark.json by default, so that
+ * they can be compared between releases.
+ *
+ * It's not registered with ctest, it has to be run by hand.
+ */
+class DummyBenchmark
+    : public QObject
+{
+    Q_OBJECT
+public:
+    DummyBenchmark(QObject* parent = nullptr): QObject(parent)
+    {
+        DiscoverBackendsFactory::setRequestedBackends({ QStringLiteral("dummy-backend") });
+
+        m_model = new ResourcesModel(QStringLiteral("dummy-backend"), this);
+        const auto backends = m_model->backends();
+        for (AbstractResourcesBackend* backend : backends) {
+            if (QLatin1String(backend->metaObject()->className()) == QLatin1String("DummyBackend"))
+                m_appBackend = backend;
+        }
+
+        CategoryModel::global()->populateCategories();
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_appBackend);
+        while (m_appBackend->isFetching()) {
+            QSignalSpy spy(m_appBackend, &AbstractResourcesBackend::fetchingChanged);
+            QVERIFY(spy.wait());
+        }
+        // Every populate() adds as many applications as addons and technical resources
+        m_size = m_appBackend->property("startElements").toInt() * 3;
+
+        if (qEnvironmentVariableIsSet("DISCOVER_BENCHMARK_ITERATIONS"))
+            m_iterations = qMax(1, qEnvironmentVariableIntValue("DISCOVER_BENCHMARK_ITERATIONS"));
+    }
+
+    void benchmark_data()
+    {
+        QTest::addColumn<QString>("name");
+        QTest::addColumn<int>("size");
+
+        // The backend can only grow, so everything runs for a size before moving on to the next
+        const auto sizes = qEnvironmentVariable("DISCOVER_BENCHMARK_SIZES", QStringLiteral("10000,50000")).split(QLatin1Char(','), Qt::SkipEmptyParts);
+        QVector<int> sorted;
+        for (const auto &size : sizes)
+            sorted += size.toInt();
+        std::sort(sorted.begin(), sorted.end());
+
+        const QStringList names = { QStringLiteral("search"), QStringLiteral("aggregatedStream"), QStringLiteral("proxyInsertion"),
+                                    QStringLiteral("proxySorting"), QStringLiteral("categoryMatching"), QStringLiteral("updateModelRebuild") };
+        for (int size : qAsConst(sorted)) {
+            for (const auto &name : names)
+                QTest::newRow(qPrintable(name + QLatin1Char('/') + QString::number(size))) << name << size;
+        }
+    }
+
+    void benchmark()
+    {
+        QFETCH(QString, name);
+        QFETCH(int, size);
+
+        grow(size);
+
+        QElapsedTimer timer;
+        QVector<qint64> nsecs;
+        int items = 0;
+        m_timedOut = false;
+        for (int i = 0; i < m_iterations; ++i) {
+            const auto run = prepare(name);
+            QVERIFY(run);
+            QVERIFY2(!m_timedOut, "timed out while preparing");
+
+            timer.start();
+            items = run();
+            nsecs += timer.nsecsElapsed();
+            QVERIFY2(!m_timedOut, "timed out");
+        }
+        QVERIFY(items > 0);
+
+        std::sort(nsecs.begin(), nsecs.end());
+        qint64 total = 0;
+        for (qint64 n : qAsConst(nsecs))
+            total += n;
+
+        const qint64 median = nsecs.at(nsecs.size() / 2);
+        m_results.append(QJsonObject {
+            { QStringLiteral("name"), name },
+            { QStringLiteral("size"), size },
+            { QStringLiteral("iterations"), nsecs.size() },
+            { QStringLiteral("items"), items },
+            { QStringLiteral("minMsecs"), nsecs.constFirst() / 1e6 },
+            { QStringLiteral("medianMsecs"), median / 1e6 },
+            { QStringLiteral("meanMsecs"), total / 1e6 / nsecs.size() },
+            { QStringLiteral("itemsPerSecond"), median > 0 ? items * 1e9 / median : 0 },
+        });
+        qDebug() << name << size << "median" << median / 1e6 << "ms for" << items << "items";
+    }
+
+    void cleanupTestCase()
+    {
+        const QJsonObject report {
+            { QStringLiteral("suite"), QStringLiteral("DummyBenchmark") },
+            { QStringLiteral("qtVersion"), QString::fromLatin1(qVersion()) },
+            { QStringLiteral("date"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate) },
+            { QStringLiteral("results"), m_results },
+        };
+
+        QFile file(qEnvironmentVariable("DISCOVER_BENCHMARK_OUTPUT", QStringLiteral("dummybenchmark.json")));
+        QVERIFY2(file.open(QIODevice::WriteOnly), qPrintable(file.errorString()));
+        file.write(QJsonDocument(report).toJson());
+        qDebug() << "benchmark results written to" << file.fileName();
+    }
+
+private:
+    void grow(int size)
+    {
+        if (size <= m_size)
+            return;
+
+        const int perType = (size - m_size + 2) / 3;
+        m_appBackend->setProperty("startElements", perType);
+        QMetaObject::invokeMethod(m_appBackend, "populate", Q_ARG(QString, QStringLiteral("Bench")));
+        m_size += perType * 3;
+    }
+
+    QVector<AbstractResource*> fetchAll(AbstractResource::State state)
+    {
+        AbstractResourcesBackend::Filters filter;
+        filter.state = state;
+        QVector<AbstractResource*> ret;
+        waitForStream(m_model->search(filter), &ret);
+        return ret;
+    }
+
+    /// Sets m_timedOut if @p stream doesn't finish in time
+    int waitForStream(AggregatedResultsStream* stream, QVector<AbstractResource*>* resources = nullptr)
+    {
+        int count = 0;
+        QObject::connect(stream, &ResultsStream::resourcesFound, stream, [&count, resources](const QVector<AbstractResource*>& res) {
+            count += res.size();
+            if (resources)
+                *resources += res;
+        });
+        QSignalSpy spy(stream, &AggregatedResultsStream::finished);
+        if (!spy.wait(s_timeout)) {
+            qWarning() << "the stream didn't finish, found" << count << "resources";
+            m_timedOut = true;
+        }
+        return count;
+    }
+
+    /// Sets m_timedOut if the proxy is still busy after @p busyChanged stopped coming
+    void waitForProxy(QSignalSpy &busyChanged)
+    {
+        while (m_proxy->isBusy()) {
+            if (!busyChanged.wait(s_timeout)) {
+                qWarning() << "the proxy model is still busy with" << m_proxy->rowCount() << "rows";
+                m_timedOut = true;
+                return;
+            }
+        }
+    }
+
+    /// @returns what to measure for @p name, which returns how many items it went through
+    std::function<int()> prepare(const QString &name)
+    {
+        if (name == QLatin1String("search")) {
+            return [this] {
+                AbstractResourcesBackend::Filters filter;
+                filter.search = QStringLiteral("Bench 12");
+                return waitForStream(m_model->search(filter));
+            };
+        } else if (name == QLatin1String("aggregatedStream")) {
+            return [this] {
+                AbstractResourcesBackend::Filters filter;
+                filter.state = AbstractResource::None;
+                return waitForStream(m_model->search(filter));
+            };
+        } else if (name == QLatin1String("proxyInsertion")) {
+            m_proxy.reset(new ResourcesProxyModel);
+            m_proxy->setStateFilter(AbstractResource::None);
+            return [this] {
+                QSignalSpy spy(m_proxy.data(), &ResourcesProxyModel::busyChanged);
+                m_proxy->componentComplete();
+                waitForProxy(spy);
+                return m_proxy->rowCount();
+            };
+        } else if (name == QLatin1String("proxySorting")) {
+            m_proxy.reset(new ResourcesProxyModel);
+            m_proxy->setStateFilter(AbstractResource::None);
+            m_proxy->setSortRole(ResourcesProxyModel::NameRole);
+            QSignalSpy spy(m_proxy.data(), &ResourcesProxyModel::busyChanged);
+            m_proxy->componentComplete();
+            waitForProxy(spy);
+            return [this] {
+                m_proxy->setSortRole(ResourcesProxyModel::SizeRole);
+                m_proxy->setSortOrder(m_proxy->sortOrder() == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder);
+                m_proxy->setSortRole(ResourcesProxyModel::NameRole);
+                return m_proxy->rowCount();
+            };
+        } else if (name == QLatin1String("categoryMatching")) {
+            m_resources = fetchAll(AbstractResource::None);
+            m_categories.clear();
+            QVector<Category*> pending = CategoryModel::global()->rootCategories();
+            while (!pending.isEmpty()) {
+                Category* category = pending.takeLast();
+                m_categories += category;
+                pending += category->subCategories();
+            }
+            return [this] {
+                m_matches = 0;
+                for (AbstractResource* resource : qAsConst(m_resources)) {
+                    for (Category* category : qAsConst(m_categories))
+                        m_matches += resource->categoryMatches(category);
+                }
+                return m_resources.size() * m_categories.size();
+            };
+        } else if (name == QLatin1String("updateModelRebuild")) {
+            const auto resources = fetchAll(AbstractResource::Upgradeable);
+            m_updates = QList<AbstractResource*>(resources.constBegin(), resources.constEnd());
+            m_updateModel.reset(new UpdateModel);
+            return [this] {
+                m_updateModel->setResources({});
+                m_updateModel->setResources(m_updates);
+                return m_updateModel->rowCount();
+            };
+        }
+        return {};
+    }
+
+    ResourcesModel* m_model = nullptr;
+    AbstractResourcesBackend* m_appBackend = nullptr;
+    int m_size = 0;
+    int m_iterations = 5;
+    bool m_timedOut = false;
+    QJsonArray m_results;
+
+    QScopedPointer<ResourcesProxyModel> m_proxy;
+    QScopedPointer<UpdateModel> m_updateModel;
+    QVector<AbstractResource*> m_resources;
+    QVector<Category*> m_categories;
+    int m_matches = 0;
+    QList<AbstractResource*> m_updates;
+};
+
+QTEST_MAIN(DummyBenchmark)
+
+#include "DummyBenchmark.moc"
@@ -130,6 +130,49 @@ void DummyTest::testProxySorting()
     }
 }
 
+static QSet<AbstractResource*> proxyResources(const ResourcesProxyModel &pm)
+{
+    QSet<AbstractResource*> ret;
+    for (int i=0, rc=pm.rowCount(); i<rc; ++i)
+        ret += pm.resourceAt(i);
+    return ret;
+}
+
+void DummyTest::testProxyRefineSearch()
+{
+    ResourcesProxyModel pm;
+    QSignalSpy spy(&pm, &ResourcesProxyModel::busyChanged);
+    pm.setSearchDelay(0);
+    pm.setFiltersFromCategory(CategoryModel::global()->rootCategories().first());
+    pm.setSearch(QStringLiteral("Dummy 1"));
+    pm.componentComplete();
+    QVERIFY(pm.isBusy());
+    QVERIFY(spy.wait());
+    QVERIFY(!pm.isBusy());
+    const int broadCount = pm.rowCount();
+    QVERIFY(broadCount > 0);
+
+    // The dummy backend can tell what still matches, the results are filtered without querying it again
+    QSignalSpy removedSpy(&pm, &ResourcesProxyModel::rowsRemoved);
+    spy.clear();
+    pm.setSearch(QStringLiteral("Dummy 12"));
+    QVERIFY(!pm.isBusy());
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(!removedSpy.isEmpty());
+    QVERIFY(pm.rowCount() > 0);
+    QVERIFY(pm.rowCount() < broadCount);
+
+    ResourcesProxyModel queried;
+    QSignalSpy queriedSpy(&queried, &ResourcesProxyModel::busyChanged);
+    queried.setSearchDelay(0);
+    queried.setFiltersFromCategory(CategoryModel::global()->rootCategories().first());
+    queried.setSearch(QStringLiteral("Dummy 12"));
+    queried.componentComplete();
+    QVERIFY(queriedSpy.wait());
+    QVERIFY(!queried.isBusy());
+    QCOMPARE(proxyResources(pm), proxyResources(queried));
+}
+
 void DummyTest::testFetch()
 {
     const auto resources = fetchResources(m_appBackend->search({}));
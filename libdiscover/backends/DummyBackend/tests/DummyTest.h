@@ -24,6 +24,7 @@ private Q_SLOTS:
     void testReadData();
     void testProxy();
     void testProxySorting();
+    void testProxyRefineSearch();
     void testFetch();
     void testSort();
     void testInstallAddons();
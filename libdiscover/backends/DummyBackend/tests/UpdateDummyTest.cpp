@@ -76,6 +76,44 @@ private Q_SLOTS:
         delete m;
     }
 
+    void testIncremental()
+    {
+        ResourcesUpdatesModel* rum = new ResourcesUpdatesModel(this);
+        UpdateModel* m = new UpdateModel(this);
+        new QAbstractItemModelTester(m, m);
+        m->setBackend(rum);
+
+        const auto resources = rum->toUpdate();
+        QVERIFY(resources.count() > 2);
+        QCOMPARE(m->rowCount(), resources.count());
+
+        QSignalSpy spyReset(m, &QAbstractItemModel::modelReset);
+        QSignalSpy spyRemoved(m, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy spyInserted(m, &QAbstractItemModel::rowsInserted);
+        const QPersistentModelIndex last = m->index(m->rowCount() - 1, 0);
+        AbstractResource* lastResource = qobject_cast<AbstractResource*>(last.data(UpdateModel::ResourceRole).value<QObject*>());
+
+        auto remaining = resources;
+        remaining.removeOne(resources.first() == lastResource ? resources.at(1) : resources.first());
+        m->setResources(remaining);
+        QCOMPARE(m->rowCount(), resources.count() - 1);
+        QCOMPARE(spyRemoved.count(), 1);
+        QCOMPARE(spyInserted.count(), 0);
+
+        m->setResources(resources);
+        QCOMPARE(m->rowCount(), resources.count());
+        QCOMPARE(spyInserted.count(), 1);
+        QCOMPARE(spyReset.count(), 0);
+        QVERIFY(last.isValid());
+        QCOMPARE(last.data(UpdateModel::ResourceRole).value<QObject*>(), lastResource);
+
+        for (int i = 1, c = m->rowCount(); i < c; ++i) {
+            QVERIFY(m->index(i - 1, 0).data(Qt::DisplayRole).toString() <= m->index(i, 0).data(Qt::DisplayRole).toString()
+                 || m->index(i - 1, 0).data(UpdateModel::SectionRole) != m->index(i, 0).data(UpdateModel::SectionRole));
+        }
+        delete m;
+    }
+
     void testUpdate()
     {
         ResourcesUpdatesModel* rum = new ResourcesUpdatesModel(this);
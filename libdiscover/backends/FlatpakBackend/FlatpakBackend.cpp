@@ -7,13 +7,18 @@
 
 #include "FlatpakBackend.h"
 #include "FlatpakFetchDataJob.h"
+#include "FlatpakRemoteRefsCache.h"
 #include "FlatpakSourcesBackend.h"
 #include "FlatpakJobTransaction.h"
+#include "FlatpakTransactionThread.h"
+#include "libdiscover_backend_debug.h"
 
 #include <utils.h>
 #include <resources/StandardBackendUpdater.h>
 #include <resources/SourcesModel.h>
+#include <resources/SearchIndex.h>
 #include <Transaction/Transaction.h>
+#include <RefreshScheduler.h>
 #include <appstream/OdrsReviewsBackend.h>
 #include <appstream/AppStreamIntegration.h>
 #include <appstream/AppStreamUtils.h>
@@ -32,6 +37,7 @@
 #include <QtConcurrentRun>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QFutureWatcher>
@@ -73,15 +79,20 @@ static FlatpakResource::Id idForInstalledRef(FlatpakInstallation *installation,
 
 FlatpakBackend::FlatpakBackend(QObject* parent)
     : AbstractResourcesBackend(parent)
+    , m_searchIndex(new SearchIndex(this))
     , m_updater(new StandardBackendUpdater(this))
     , m_reviews(AppStreamIntegration::global()->reviews())
     , m_refreshAppstreamMetadataJobs(0)
     , m_cancellable(g_cancellable_new())
     , m_threadPool(new QThreadPool(this))
+    , m_remoteRefs(new FlatpakRemoteRefsCache(&m_threadPool, m_cancellable, this))
+    , m_refreshScheduler(new RefreshScheduler(QStringLiteral("Flatpak"), std::chrono::hours(24), this))
 {
     g_autoptr(GError) error = nullptr;
 
     connect(m_updater, &StandardBackendUpdater::updatesCountChanged, this, &FlatpakBackend::updatesCountChanged);
+    m_updater->setBatchUpdates(true);
+    connect(m_remoteRefs, &FlatpakRemoteRefsCache::refsChanged, this, &FlatpakBackend::remoteRefsChanged);
 
     // Load flatpak installation
     if (!setupFlatpakInstallations(&error)) {
@@ -248,12 +259,9 @@ FlatpakResource * FlatpakBackend::getRuntimeForApp(FlatpakResource *resource) co
         return runtime;
     }
 
-    for (auto it = m_resources.constBegin(), itEnd = m_resources.constEnd(); it!=itEnd; ++it) {
-        const auto& id = it.key();
-        if (id.type == FlatpakResource::Runtime && id.id == runtimeInfo.at(0) && id.branch == runtimeInfo.at(2)) {
-            runtime = *it;
-            break;
-        }
+    const auto runtimes = m_runtimes.value(runtimeInfo.at(0) + QLatin1Char('/') + runtimeInfo.at(2));
+    if (!runtimes.isEmpty()) {
+        runtime = runtimes.constFirst();
     }
 
     // TODO if runtime wasn't found, create a new one from available info
@@ -543,13 +551,146 @@ void FlatpakBackend::addResource(FlatpakResource *resource)
 
     updateAppState(resource);
 
-    m_resources.insert(resource->uniqueId(), resource);
+    auto& resPos = m_resources[resource->uniqueId()];
+    if (resPos != resource) {
+        if (resPos)
+            unindexResource(resPos);
+        resPos = resource;
+        indexResource(resource);
+    }
     if (!resource->extends().isEmpty()) {
         m_extends.append(resource->extends());
         m_extends.removeDuplicates();
     }
 }
 
+static QStringList appstreamIdKeys(FlatpakResource *resource)
+{
+    QStringList ret = { resource->appstreamId().toCaseFolded() };
+    const auto alts = resource->alternativeAppstreamIds();
+    for (const auto &alt : alts)
+        ret += alt.toCaseFolded();
+    ret.removeDuplicates();
+    return ret;
+}
+
+static QString runtimeKey(const FlatpakResource::Id &id)
+{
+    return id.id + QLatin1Char('/') + id.branch;
+}
+
+static quint64 trigramKey(const QChar* c)
+{
+    return quint64(c[0].unicode()) << 32 | quint64(c[1].unicode()) << 16 | quint64(c[2].unicode());
+}
+
+// Any case insensitive substring of 3 or more characters contains at least one of these,
+// which works the same regardless of the script, unlike splitting at word boundaries
+static QSet<quint64> textTrigrams(const QString &text)
+{
+    QSet<quint64> ret;
+    const QString folded = text.toCaseFolded();
+    for (int i = 0, c = folded.size() - 2; i < c; ++i)
+        ret.insert(trigramKey(folded.constData() + i));
+    return ret;
+}
+
+static QSet<quint64> resourceTrigrams(FlatpakResource *resource)
+{
+    return textTrigrams(resource->name()).unite(textTrigrams(resource->comment()));
+}
+
+void FlatpakBackend::indexResource(FlatpakResource *resource)
+{
+    const auto ids = appstreamIdKeys(resource);
+    for (const auto &id : ids)
+        m_resourcesByAppstreamId[id] += resource;
+
+    const auto trigrams = resourceTrigrams(resource);
+    for (auto trigram : trigrams)
+        m_textIndex[trigram] += resource;
+
+    const auto component = resource->appstreamComponent();
+    m_searchIndex->insert(resource, { resource->appstreamId(), resource->name(), resource->comment(), component.keywords(), resource->categories() });
+
+    const auto id = resource->uniqueId();
+    if (id.type == FlatpakResource::Runtime)
+        m_runtimes[runtimeKey(id)] += resource;
+}
+
+void FlatpakBackend::updateResourceFromRef(FlatpakResource *resource, FlatpakRef *ref)
+{
+    auto it = m_resources.find(resource->uniqueId());
+    if (it == m_resources.end() || *it != resource) {
+        resource->updateFromRef(ref);
+        return;
+    }
+
+    // The index has to be cleared with the values it was built from
+    unindexResource(resource);
+    m_resources.erase(it);
+    resource->updateFromRef(ref);
+
+    auto& resPos = m_resources[resource->uniqueId()];
+    if (resPos)
+        unindexResource(resPos);
+    resPos = resource;
+    indexResource(resource);
+}
+
+void FlatpakBackend::unindexResource(FlatpakResource *resource)
+{
+    const auto ids = appstreamIdKeys(resource);
+    for (const auto &id : ids) {
+        auto it = m_resourcesByAppstreamId.find(id);
+        if (it != m_resourcesByAppstreamId.end() && it->removeAll(resource) && it->isEmpty())
+            m_resourcesByAppstreamId.erase(it);
+    }
+
+    const auto trigrams = resourceTrigrams(resource);
+    for (auto trigram : trigrams) {
+        auto it = m_textIndex.find(trigram);
+        if (it != m_textIndex.end() && it->removeAll(resource) && it->isEmpty())
+            m_textIndex.erase(it);
+    }
+    m_searchIndex->remove(resource);
+
+    const auto id = resource->uniqueId();
+    if (id.type == FlatpakResource::Runtime) {
+        auto it = m_runtimes.find(runtimeKey(id));
+        if (it != m_runtimes.end() && it->removeAll(resource) && it->isEmpty())
+            m_runtimes.erase(it);
+    }
+}
+
+QVector<FlatpakResource*> FlatpakBackend::searchCandidates(const QString &search) const
+{
+    const QString folded = search.toCaseFolded();
+    if (folded.size() < 3)
+        return kTransform<QVector<FlatpakResource*>>(m_resources);
+
+    // Every match has all the trigrams of the search, so the shortest posting list is enough.
+    // The caller still checks the actual text
+    const QVector<FlatpakResource*>* best = nullptr;
+    for (int i = 0, c = folded.size() - 2; i < c; ++i) {
+        auto it = m_textIndex.constFind(trigramKey(folded.constData() + i));
+        if (it == m_textIndex.constEnd()) {
+            best = nullptr;
+            break;
+        }
+        if (!best || it->size() < best->size())
+            best = &*it;
+    }
+
+    QVector<FlatpakResource*> ret = best ? *best : QVector<FlatpakResource*>();
+    const auto byId = m_resourcesByAppstreamId.value(folded);
+    for (auto r : byId) {
+        if (!ret.contains(r))
+            ret += r;
+    }
+    return ret;
+}
+
 class FlatpakSource
 {
 public:
@@ -580,6 +721,11 @@ private:
     FlatpakRemote* m_remote;
 };
 
+static QString remoteTimingKey(FlatpakInstallation *installation, const QString &remoteName)
+{
+    return QString::fromUtf8(flatpak_installation_get_id(installation)) + QLatin1Char('/') + remoteName;
+}
+
 void FlatpakBackend::loadAppsFromAppstreamData()
 {
     for (auto installation : qAsConst(m_installations)) {
@@ -587,45 +733,73 @@ void FlatpakBackend::loadAppsFromAppstreamData()
         if (g_cancellable_is_cancelled(m_cancellable))
             break;
 
-        if (!loadAppsFromAppstreamData(installation)) {
-            qWarning() << "Failed to load packages from appstream data from installation" << installation;
-        }
+        loadAppsFromAppstreamData(installation);
     }
 }
 
-bool FlatpakBackend::loadAppsFromAppstreamData(FlatpakInstallation *flatpakInstallation)
+void FlatpakBackend::loadAppsFromAppstreamData(FlatpakInstallation *flatpakInstallation)
 {
     Q_ASSERT(flatpakInstallation);
 
-    g_autoptr(GPtrArray) remotes = flatpak_installation_list_remotes(flatpakInstallation, m_cancellable, nullptr);
-    if (!remotes) {
-        return false;
-    }
+    // Holds metadataRefreshed() back until we know how many remotes this installation has
+    m_refreshAppstreamMetadataJobs++;
+    acquireFetching(true);
 
-    m_refreshAppstreamMetadataJobs += remotes->len;
+    // The remotes and whether their appstream metadata needs to be refreshed
+    typedef QVector<QPair<FlatpakRemote*, bool>> Remotes;
+    auto fw = new QFutureWatcher<Remotes>(this);
+    connect(fw, &QFutureWatcher<Remotes>::finished, this, [this, fw, flatpakInstallation]() {
+        const auto remotes = fw->result();
+        if (remotes.isEmpty()) {
+            qWarning() << "Failed to load packages from appstream data from installation" << flatpakInstallation;
+        }
 
-    for (uint i = 0; i < remotes->len; i++) {
-        FlatpakRemote *remote = FLATPAK_REMOTE(g_ptr_array_index(remotes, i));
-        g_autoptr(GFile) fileTimestamp = flatpak_remote_get_appstream_timestamp(remote, flatpak_get_default_arch());
+        m_refreshAppstreamMetadataJobs += remotes.size();
+        for (const auto &remote : remotes) {
+            if (remote.second) {
+                refreshAppstreamMetadata(flatpakInstallation, remote.first);
+            } else {
+                integrateRemote(flatpakInstallation, remote.first);
+            }
+            g_object_unref(remote.first);
+        }
 
-        g_autofree char *path_str = g_file_get_path(fileTimestamp);
-        QFileInfo fileInfo = QFileInfo(QString::fromUtf8(path_str));
-        // Refresh appstream metadata in case they have never been refreshed or the cache is older than 6 hours
-        if (!fileInfo.exists() || fileInfo.lastModified().toUTC().secsTo(QDateTime::currentDateTimeUtc()) > 21600) {
-            refreshAppstreamMetadata(flatpakInstallation, remote);
-        } else {
-            integrateRemote(flatpakInstallation, remote);
+        metadataRefreshed();
+        acquireFetching(false);
+        fw->deleteLater();
+    });
+    fw->setFuture(QtConcurrent::run(&m_threadPool, [flatpakInstallation, this]() -> Remotes {
+        g_autoptr(GPtrArray) remotes = flatpak_installation_list_remotes(flatpakInstallation, m_cancellable, nullptr);
+        if (!remotes) {
+            return {};
         }
-    }
-    return true;
+
+        Remotes ret;
+        ret.reserve(remotes->len);
+        for (uint i = 0; i < remotes->len; i++) {
+            FlatpakRemote *remote = FLATPAK_REMOTE(g_ptr_array_index(remotes, i));
+            g_autoptr(GFile) fileTimestamp = flatpak_remote_get_appstream_timestamp(remote, flatpak_get_default_arch());
+
+            g_autofree char *path_str = g_file_get_path(fileTimestamp);
+            QFileInfo fileInfo = QFileInfo(QString::fromUtf8(path_str));
+            // Refresh appstream metadata in case they have never been refreshed or the cache is older than 6 hours
+            const bool needsRefresh = !fileInfo.exists() || fileInfo.lastModified().toUTC().secsTo(QDateTime::currentDateTimeUtc()) > 21600;
+            ret.append({ FLATPAK_REMOTE(g_object_ref(remote)), needsRefresh });
+        }
+        return ret;
+    }));
 }
 
 void FlatpakBackend::metadataRefreshed()
 {
     m_refreshAppstreamMetadataJobs--;
     if (m_refreshAppstreamMetadataJobs == 0) {
+        for (auto it = m_remoteTimings.constBegin(), itEnd = m_remoteTimings.constEnd(); it != itEnd; ++it) {
+            qCDebug(LIBDISCOVER_BACKEND_LOG) << "loaded remote" << it.key() << "refresh:" << it->refresh << "parse:" << it->parse << "integrate:" << it->integrate;
+        }
+        m_remoteTimings.clear();
+        // Updates are looked for once each installation is loaded
         loadInstalledApps();
-        checkForUpdates();
     }
 }
 
@@ -648,10 +822,18 @@ void FlatpakBackend::integrateRemote(FlatpakInstallation *flatpakInstallation, F
         return;
     }
 
-    auto fw = new QFutureWatcher<QList<AppStream::Component>>(this);
+    // Components and how long parsing took, not counting the wait for a thread
+    typedef QPair<QList<AppStream::Component>, qint64> Parsed;
+    auto fw = new QFutureWatcher<Parsed>(this);
     const auto sourceName = source.name();
-    connect(fw, &QFutureWatcher<QList<AppStream::Component>>::finished, this, [this, fw, flatpakInstallation, appstreamIconsPath, sourceName]() {
-        const auto components = fw->result();
+    connect(fw, &QFutureWatcher<Parsed>::finished, this, [this, fw, flatpakInstallation, appstreamIconsPath, sourceName]() {
+        auto& timing = m_remoteTimings[remoteTimingKey(flatpakInstallation, sourceName)];
+        const auto parsed = fw->result();
+        timing.parse = parsed.second;
+        QElapsedTimer integrateTimer;
+        integrateTimer.start();
+
+        const auto &components = parsed.first;
         QVector<FlatpakResource*> resources;
         for (const AppStream::Component& appstreamComponent : components) {
             FlatpakResource *resource = new FlatpakResource(appstreamComponent, flatpakInstallation, this);
@@ -666,136 +848,192 @@ void FlatpakBackend::integrateRemote(FlatpakInstallation *flatpakInstallation, F
         for (auto resource : qAsConst(resources)) {
             addResource(resource);
         }
+        timing.integrate = integrateTimer.elapsed();
 
         metadataRefreshed();
         acquireFetching(false);
         fw->deleteLater();
     });
     acquireFetching(true);
-    fw->setFuture(QtConcurrent::run(&m_threadPool, [appDirFileName]() -> QList<AppStream::Component> {
+    fw->setFuture(QtConcurrent::run(&m_threadPool, [appDirFileName]() -> Parsed {
+        QElapsedTimer parseTimer;
+        parseTimer.start();
         AppStream::Metadata metadata;
         metadata.setFormatStyle(AppStream::Metadata::FormatStyleCollection);
         AppStream::Metadata::MetadataError error = metadata.parseFile(appDirFileName, AppStream::Metadata::FormatKindXml);
         if (error != AppStream::Metadata::MetadataErrorNoError) {
             qWarning() << "Failed to parse appstream metadata: " << error;
-            return {};
+            return { {}, parseTimer.elapsed() };
         }
 
-        return metadata.components();
+        return { metadata.components(), parseTimer.elapsed() };
     }));
 }
 
 void FlatpakBackend::loadInstalledApps()
 {
     for (auto installation : qAsConst(m_installations)) {
+        if (g_cancellable_is_cancelled(m_cancellable))
+            break;
+
         // Load installed applications and update existing resources with info from installed application
-        if (!loadInstalledApps(installation)) {
-            qWarning() << "Failed to load installed packages from installation" << installation;
-        }
+        loadInstalledApps(installation);
     }
 }
 
-bool FlatpakBackend::loadInstalledApps(FlatpakInstallation *flatpakInstallation)
+void FlatpakBackend::loadInstalledApps(FlatpakInstallation *flatpakInstallation)
 {
     Q_ASSERT(flatpakInstallation);
 
-    g_autoptr(GError) localError = nullptr;
-    g_autoptr(GPtrArray) refs = flatpak_installation_list_installed_refs(flatpakInstallation, m_cancellable, &localError);
-    if (!refs) {
-        qWarning() << "Failed to get list of installed refs for listing updates:" << localError->message;
-        return false;
-    }
-
     const QString pathExports = FlatpakResource::installationPath(flatpakInstallation) + QLatin1String("/exports/");
     const QString pathApps = pathExports + QLatin1String("share/applications/");
 
-    QVector<FlatpakResource*> resources;
-    for (uint i = 0; i < refs->len; i++) {
-        FlatpakInstalledRef *ref = FLATPAK_INSTALLED_REF(g_ptr_array_index(refs, i));
+    // Installed refs, referenced for us, with the component read from their desktop file
+    typedef QVector<QPair<FlatpakInstalledRef*, AppStream::Component>> InstalledApps;
+    auto fw = new QFutureWatcher<InstalledApps>(this);
+    connect(fw, &QFutureWatcher<InstalledApps>::finished, this, [this, fw, flatpakInstallation, pathExports]() {
+        const auto apps = fw->result();
+        QVector<FlatpakResource*> resources;
+        for (const auto &app : apps) {
+            FlatpakInstalledRef *ref = app.first;
+            const auto res = getAppForInstalledRef(flatpakInstallation, ref);
+            if (res) {
+                res->setState(AbstractResource::Installed);
+            } else {
+                FlatpakResource *resource = new FlatpakResource(app.second, flatpakInstallation, this);
 
-        const auto name = QLatin1String(flatpak_ref_get_name(FLATPAK_REF(ref)));
-        if (name.endsWith(QLatin1String(".Debug")) || name.endsWith(QLatin1String(".Locale")) || name.endsWith(QLatin1String(".BaseApp")) || name.endsWith(QLatin1String(".Docs")))
-            continue;
+                resource->setIconPath(pathExports);
+                resource->setState(AbstractResource::Installed);
+                resource->setOrigin(QString::fromUtf8(flatpak_installed_ref_get_origin(ref)));
+                resource->updateFromRef(FLATPAK_REF(ref));
 
-        const auto res = getAppForInstalledRef(flatpakInstallation, ref);
-        if (res) {
-            res->setState(AbstractResource::Installed);
-            continue;
+                if (resource->resourceType() == FlatpakResource::Runtime) {
+                    resources.prepend(resource);
+                } else {
+                    resources.append(resource);
+                }
+            }
+            g_object_unref(ref);
+        }
+        for (auto resource : qAsConst(resources))
+            addResource(resource);
+
+        loadUpdates(flatpakInstallation);
+        acquireFetching(false);
+        fw->deleteLater();
+    });
+    acquireFetching(true);
+    fw->setFuture(QtConcurrent::run(&m_threadPool, [flatpakInstallation, pathApps, this]() -> InstalledApps {
+        g_autoptr(GError) localError = nullptr;
+        g_autoptr(GPtrArray) refs = flatpak_installation_list_installed_refs(flatpakInstallation, m_cancellable, &localError);
+        if (!refs) {
+            qWarning() << "Failed to get list of installed refs for listing updates:" << localError->message;
+            return {};
         }
 
-        AppStream::Component cid;
-        AppStream::Metadata metadata;
-        const QString fnDesktop = pathApps + name + QLatin1String(".desktop");
-        AppStream::Metadata::MetadataError error = metadata.parseFile(fnDesktop, AppStream::Metadata::FormatKindDesktopEntry);
-        if (error != AppStream::Metadata::MetadataErrorNoError) {
-            if (QFile::exists(fnDesktop))
-                qDebug() << "Failed to parse appstream metadata:" << error << fnDesktop;
+        InstalledApps ret;
+        for (uint i = 0; i < refs->len; i++) {
+            FlatpakInstalledRef *ref = FLATPAK_INSTALLED_REF(g_ptr_array_index(refs, i));
+
+            const auto name = QLatin1String(flatpak_ref_get_name(FLATPAK_REF(ref)));
+            if (name.endsWith(QLatin1String(".Debug")) || name.endsWith(QLatin1String(".Locale")) || name.endsWith(QLatin1String(".BaseApp")) || name.endsWith(QLatin1String(".Docs")))
+                continue;
 
-            cid.setId(QString::fromLatin1(flatpak_ref_get_name(FLATPAK_REF(ref))));
+            AppStream::Component cid;
+            AppStream::Metadata metadata;
+            const QString fnDesktop = pathApps + name + QLatin1String(".desktop");
+            AppStream::Metadata::MetadataError error = metadata.parseFile(fnDesktop, AppStream::Metadata::FormatKindDesktopEntry);
+            if (error != AppStream::Metadata::MetadataErrorNoError) {
+                if (QFile::exists(fnDesktop))
+                    qDebug() << "Failed to parse appstream metadata:" << error << fnDesktop;
+
+                cid.setId(QString::fromLatin1(flatpak_ref_get_name(FLATPAK_REF(ref))));
 #if FLATPAK_CHECK_VERSION(1,1,2)
-            cid.setName(QString::fromUtf8(flatpak_installed_ref_get_appdata_name(ref)));
+                cid.setName(QString::fromUtf8(flatpak_installed_ref_get_appdata_name(ref)));
 #endif
-        } else
-            cid = metadata.component();
+            } else
+                cid = metadata.component();
 
-        FlatpakResource *resource = new FlatpakResource(cid, flatpakInstallation, this);
+            ret.append({ FLATPAK_INSTALLED_REF(g_object_ref(ref)), cid });
+        }
+        return ret;
+    }));
+}
 
-        resource->setIconPath(pathExports);
-        resource->setState(AbstractResource::Installed);
-        resource->setOrigin(QString::fromUtf8(flatpak_installed_ref_get_origin(ref)));
-        resource->updateFromRef(FLATPAK_REF(ref));
+void FlatpakBackend::loadUpdates(FlatpakInstallation *flatpakInstallation)
+{
+    if (g_cancellable_is_cancelled(m_cancellable))
+        return;
 
-        if (resource->resourceType() == FlatpakResource::Runtime) {
-            resources.prepend(resource);
-        } else {
-            resources.append(resource);
-        }
-    }
-    for (auto resource : qAsConst(resources))
-        addResource(resource);
+    // Load local updates, comparing current and latest commit
+    loadLocalUpdates(flatpakInstallation);
 
-    return true;
+    // Load updates from remote repositories
+    loadRemoteUpdates(flatpakInstallation);
 }
 
 void FlatpakBackend::loadLocalUpdates(FlatpakInstallation *flatpakInstallation)
 {
-    g_autoptr(GError) localError = nullptr;
-    g_autoptr(GPtrArray) refs = flatpak_installation_list_installed_refs(flatpakInstallation, m_cancellable, &localError);
-    if (!refs) {
-        qWarning() << "Failed to get list of installed refs for listing updates:" << localError->message;
-        return;
-    }
+    auto fw = new QFutureWatcher<GPtrArray *>(this);
+    connect(fw, &QFutureWatcher<GPtrArray *>::finished, this, [this, flatpakInstallation, fw]() {
+        g_autoptr(GPtrArray) refs = fw->result();
+        for (uint i = 0; refs && i < refs->len; i++) {
+            FlatpakInstalledRef *ref = FLATPAK_INSTALLED_REF(g_ptr_array_index(refs, i));
+            FlatpakResource *resource = getAppForInstalledRef(flatpakInstallation, ref);
+            if (resource) {
+                resource->setState(AbstractResource::Upgradeable);
+                updateAppSize(resource);
+            }
+        }
+        fw->deleteLater();
+        acquireFetching(false);
+    });
+    acquireFetching(true);
+    fw->setFuture(QtConcurrent::run(&m_threadPool, [flatpakInstallation, this]() -> GPtrArray * {
+        g_autoptr(GError) localError = nullptr;
+        g_autoptr(GPtrArray) refs = flatpak_installation_list_installed_refs(flatpakInstallation, m_cancellable, &localError);
+        if (!refs) {
+            qWarning() << "Failed to get list of installed refs for listing updates:" << localError->message;
+            return nullptr;
+        }
 
-    for (uint i = 0; i < refs->len; i++) {
-        FlatpakInstalledRef *ref = FLATPAK_INSTALLED_REF(g_ptr_array_index(refs, i));
+        GPtrArray *ret = g_ptr_array_new_with_free_func(g_object_unref);
+        for (uint i = 0; i < refs->len; i++) {
+            FlatpakInstalledRef *ref = FLATPAK_INSTALLED_REF(g_ptr_array_index(refs, i));
 
-        const gchar *latestCommit = flatpak_installed_ref_get_latest_commit(ref);
+            const gchar *latestCommit = flatpak_installed_ref_get_latest_commit(ref);
 
-        if (!latestCommit) {
-            qWarning() << "Couldn't get latest commit for" << flatpak_ref_get_name(FLATPAK_REF(ref));
-            continue;
-        }
+            if (!latestCommit) {
+                qWarning() << "Couldn't get latest commit for" << flatpak_ref_get_name(FLATPAK_REF(ref));
+                continue;
+            }
 
-        const gchar *commit = flatpak_ref_get_commit(FLATPAK_REF(ref));
-        if (g_strcmp0(commit, latestCommit) == 0) {
-            continue;
-        }
+            const gchar *commit = flatpak_ref_get_commit(FLATPAK_REF(ref));
+            if (g_strcmp0(commit, latestCommit) == 0) {
+                continue;
+            }
 
-        FlatpakResource *resource = getAppForInstalledRef(flatpakInstallation, ref);
-        if (resource) {
-            resource->setState(AbstractResource::Upgradeable);
-            updateAppSize(resource);
+            g_ptr_array_add(ret, g_object_ref(ref));
         }
-    }
+        return ret;
+    }));
 }
 
 void FlatpakBackend::loadRemoteUpdates(FlatpakInstallation* installation)
 {
+    if (m_pendingUpdateLoads++ == 0)
+        m_updateLoadsFailed = false;
+
     auto fw = new QFutureWatcher<GPtrArray *>(this);
     connect(fw, &QFutureWatcher<GPtrArray *>::finished, this, [this, installation, fw]() {
         g_autoptr(GPtrArray) refs = fw->result();
         onFetchUpdatesFinished(installation, refs);
         fw->deleteLater();
+        m_updateLoadsFailed |= !refs;
+
+        // Listing the updates is what refreshes the remotes, it's only shared once they all answered
+        if (--m_pendingUpdateLoads == 0 && m_refreshScheduler->isRefreshing())
+            m_refreshScheduler->finish(!m_updateLoadsFailed && !g_cancellable_is_cancelled(m_cancellable));
         acquireFetching(false);
     });
     acquireFetching(true);
@@ -912,6 +1150,14 @@ void FlatpakBackend::refreshAppstreamMetadata(FlatpakInstallation *installation,
     connect(job, &FlatpakRefreshAppstreamMetadataJob::jobRefreshAppstreamMetadataFailed, this, [this] (const QString &errorMessage) {
         Q_EMIT passiveMessage(errorMessage);
     });
+    QElapsedTimer refreshTimer;
+    refreshTimer.start();
+    connect(job, &FlatpakRefreshAppstreamMetadataJob::jobRefreshAppstreamMetadataFinished, this, [this, refreshTimer] (FlatpakInstallation *installation, FlatpakRemote *remote) {
+        const QString remoteName = QString::fromUtf8(flatpak_remote_get_name(remote));
+        m_remoteTimings[remoteTimingKey(installation, remoteName)].refresh = refreshTimer.elapsed();
+        // The summary was refreshed as well, sizes and metadata need to be listed again
+        m_remoteRefs->invalidate(installation, remoteName);
+    });
     connect(job, &FlatpakRefreshAppstreamMetadataJob::jobRefreshAppstreamMetadataFinished, this, &FlatpakBackend::integrateRemote);
     connect(job, &FlatpakRefreshAppstreamMetadataJob::finished, this, [this] { acquireFetching(false); });
 
@@ -950,7 +1196,7 @@ bool FlatpakBackend::setupFlatpakInstallations(GError **error)
 void FlatpakBackend::updateAppInstalledMetadata(FlatpakInstalledRef *installedRef, FlatpakResource *resource)
 {
     // Update the rest
-    resource->updateFromRef(FLATPAK_REF(installedRef));
+    updateResourceFromRef(resource, FLATPAK_REF(installedRef));
     resource->setInstalledSize(flatpak_installed_ref_get_installed_size(installedRef));
     resource->setOrigin(QString::fromUtf8(flatpak_installed_ref_get_origin(installedRef)));
     if (resource->state() < AbstractResource::Installed)
@@ -968,14 +1214,28 @@ bool FlatpakBackend::updateAppMetadata(FlatpakResource *resource)
     if (QFile::exists(path)) {
         return updateAppMetadata(resource, path);
     } else {
-        auto fw = new QFutureWatcher<QByteArray>(this);
-        connect(fw, &QFutureWatcher<QByteArray>::finished, this, [this, resource, fw]() {
-            const auto metadata = fw->result();
-            if (!metadata.isEmpty())
-                onFetchMetadataFinished(resource, metadata);
-            fw->deleteLater();
+        m_remoteRefs->fetch(resource, [this, resource](const FlatpakRemoteRefInfo *info) {
+            if (!info || info->metadata.isEmpty()) {
+                // The summary doesn't carry the metadata of every ref, ask for this one alone
+                auto fw = new QFutureWatcher<QByteArray>(this);
+                connect(fw, &QFutureWatcher<QByteArray>::finished, this, [this, resource, fw]() {
+                    const auto metadata = fw->result();
+                    if (!metadata.isEmpty())
+                        onFetchMetadataFinished(resource, metadata);
+                    else
+                        qWarning() << "Failed to get metadata file for" << resource->ref();
+                    fw->deleteLater();
+                });
+                fw->setFuture(QtConcurrent::run(&m_threadPool, &FlatpakRunnables::fetchMetadata, resource, m_cancellable));
+                return;
+            }
+            if (info->runtime.isEmpty()) {
+                onFetchMetadataFinished(resource, info->metadata);
+            } else {
+                resource->setRuntime(info->runtime);
+                updateAppSizeFromRemote(resource);
+            }
         });
-        fw->setFuture(QtConcurrent::run(&m_threadPool, &FlatpakRunnables::fetchMetadata, resource, m_cancellable));
 
         // Return false to indicate we cannot continue (right now used only in updateAppSize())
         return false;
@@ -1082,26 +1342,41 @@ bool FlatpakBackend::updateAppSizeFromRemote(FlatpakResource *resource)
             return true;
         }
 
-        auto futureWatcher = new QFutureWatcher<FlatpakRemoteRef*>(this);
-        connect(futureWatcher, &QFutureWatcher<FlatpakRemoteRef*>::finished, this, [this, resource, futureWatcher]() {
-            g_autoptr(FlatpakRemoteRef) remoteRef = futureWatcher->result();
-            if (remoteRef) {
-                onFetchSizeFinished(resource, flatpak_remote_ref_get_download_size(remoteRef), flatpak_remote_ref_get_installed_size(remoteRef));
+        resource->setPropertyState(FlatpakResource::DownloadSize, FlatpakResource::Fetching);
+        resource->setPropertyState(FlatpakResource::InstalledSize, FlatpakResource::Fetching);
+
+        // All the refs of the remote are listed at once, so this is immediate for the rest of them
+        m_remoteRefs->fetch(resource, [this, resource](const FlatpakRemoteRefInfo *info) {
+            if (info) {
+                onFetchSizeFinished(resource, info->downloadSize, info->installedSize);
             } else {
                 resource->setPropertyState(FlatpakResource::DownloadSize, FlatpakResource::UnknownOrFailed);
                 resource->setPropertyState(FlatpakResource::InstalledSize, FlatpakResource::UnknownOrFailed);
             }
-            futureWatcher->deleteLater();
         });
-        resource->setPropertyState(FlatpakResource::DownloadSize, FlatpakResource::Fetching);
-        resource->setPropertyState(FlatpakResource::InstalledSize, FlatpakResource::Fetching);
-
-        futureWatcher->setFuture(QtConcurrent::run(&m_threadPool, &FlatpakRunnables::findRemoteRef, resource, m_cancellable));
     }
 
     return true;
 }
 
+void FlatpakBackend::remoteRefsChanged(FlatpakInstallation *installation, const QString &remote, const QStringList &refs)
+{
+    // Sizes and runtimes were taken from a listing that has new commits now
+    const auto changed = kToSet(refs);
+    for (auto resource : qAsConst(m_resources)) {
+        if (resource->installation() != installation || resource->origin() != remote || !changed.contains(resource->ref()))
+            continue;
+
+        if (resource->state() == AbstractResource::Upgradeable) {
+            // The installed runtime is what counts, only the size of the update changed
+            updateAppSizeFromRemote(resource);
+        } else if (!resource->isInstalled() && updateAppMetadata(resource)) {
+            // Apps get their size once the new runtime is known
+            updateAppSizeFromRemote(resource);
+        }
+    }
+}
+
 void FlatpakBackend::onFetchSizeFinished(FlatpakResource *resource, guint64 downloadSize, guint64 installedSize)
 {
     FlatpakResource *runtime = nullptr;
@@ -1149,11 +1424,36 @@ int FlatpakBackend::updatesCount() const
     return m_updater->updatesCount();
 }
 
-bool FlatpakBackend::flatpakResourceLessThan(AbstractResource* l, AbstractResource* r) const
+void FlatpakBackend::sortByOriginRank(QVector<AbstractResource*> &resources, const QHash<AbstractResource*, double> &relevance) const
 {
-    return (l->isInstalled() != r->isInstalled()) ? l->isInstalled()
-           : (l->origin() != r->origin()) ? m_sources->originIndex(l->origin()) < m_sources->originIndex(r->origin())
-           : l < r;
+    struct SortKey {
+        bool installed;
+        int originRank;
+        double relevance;
+        AbstractResource* resource;
+    };
+
+    // originIndex() looks the source up by id, ask once per origin rather than once per comparison
+    QHash<QString, int> originRanks;
+    QVector<SortKey> keys;
+    keys.reserve(resources.size());
+    for (auto r : qAsConst(resources)) {
+        const QString origin = r->origin();
+        auto it = originRanks.constFind(origin);
+        if (it == originRanks.constEnd())
+            it = originRanks.insert(origin, m_sources->originIndex(origin));
+        keys.append({ r->isInstalled(), *it, relevance.value(r), r });
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const SortKey &l, const SortKey &r) {
+        return (l.installed != r.installed) ? l.installed
+               : (l.originRank != r.originRank) ? l.originRank < r.originRank
+               : (l.relevance != r.relevance) ? l.relevance > r.relevance
+               : l.resource < r.resource;
+    });
+
+    for (int i = 0, c = keys.size(); i < c; ++i)
+        resources[i] = keys[i].resource;
 }
 
 ResultsStream * FlatpakBackend::search(const AbstractResourcesBackend::Filters &filter)
@@ -1180,7 +1480,8 @@ ResultsStream * FlatpakBackend::search(const AbstractResourcesBackend::Filters &
     auto stream = new ResultsStream(QStringLiteral("FlatpakStream"));
     auto f = [this, stream, filter] () {
         QVector<AbstractResource*> ret;
-        for (auto r : qAsConst(m_resources)) {
+        const auto candidates = filter.search.isEmpty() ? kTransform<QVector<FlatpakResource*>>(m_resources) : searchCandidates(filter.search);
+        for (auto r : candidates) {
             const bool matchById = r->appstreamId().compare(filter.search, Qt::CaseInsensitive) == 0;
             if (r->type() == AbstractResource::Technical && filter.state != AbstractResource::Upgradeable && !matchById) {
                 continue;
@@ -1196,10 +1497,12 @@ ResultsStream * FlatpakBackend::search(const AbstractResourcesBackend::Filters &
                 ret += r;
             }
         }
-        auto f = [this](AbstractResource* l, AbstractResource* r) {
-            return flatpakResourceLessThan(l,r);
-        };
-        std::sort(ret.begin(), ret.end(), f);
+        QHash<AbstractResource*, double> relevance;
+        if (!filter.search.isEmpty() && ret.size() > 1) {
+            for (auto r : qAsConst(ret))
+                relevance.insert(r, m_searchIndex->score(r, filter.search));
+        }
+        sortByOriginRank(ret, relevance);
         if (!ret.isEmpty())
             Q_EMIT stream->resourcesFound(ret);
         stream->finish();
@@ -1214,25 +1517,14 @@ ResultsStream * FlatpakBackend::search(const AbstractResourcesBackend::Filters &
 
 QVector<AbstractResource *> FlatpakBackend::resourcesByAppstreamName(const QString& name) const
 {
-    QVector<AbstractResource*> resources;
-    const QString nameWithDesktop = name + QLatin1String(".desktop");
-    for (FlatpakResource* res : m_resources) {
-        if (QString::compare(res->appstreamId(), name, Qt::CaseInsensitive)==0 || QString::compare(res->appstreamId(), nameWithDesktop, Qt::CaseInsensitive)==0)
+    const QString folded = name.toCaseFolded();
+    QVector<AbstractResource*> resources = kTransform<QVector<AbstractResource*>>(m_resourcesByAppstreamId.value(folded));
+    const auto withDesktop = m_resourcesByAppstreamId.value(folded + QLatin1String(".desktop"));
+    for (auto res : withDesktop) {
+        if (!resources.contains(res))
             resources << res;
-        else {
-            const auto alts = res->alternativeAppstreamIds();
-            for (const auto &alt : alts) {
-                if (QString::compare(alt, name, Qt::CaseInsensitive)==0 || QString::compare(alt, nameWithDesktop, Qt::CaseInsensitive)==0) {
-                    resources << res;
-                    break;
-                }
-            }
-        }
     }
-    auto f = [this](AbstractResource* l, AbstractResource* r) {
-        return flatpakResourceLessThan(l, r);
-    };
-    std::sort(resources.begin(), resources.end(), f);
+    sortByOriginRank(resources);
     return resources;
 }
 
@@ -1293,7 +1585,16 @@ Transaction* FlatpakBackend::installApplication(AbstractResource *app, const Add
         return nullptr;
     }
 
-    FlatpakJobTransaction *transaction = new FlatpakJobTransaction(resource, Transaction::InstallRole);
+    return watchInstallation(new FlatpakJobTransaction(resource, Transaction::InstallRole), resource);
+}
+
+Transaction* FlatpakBackend::installApplication(AbstractResource *app)
+{
+    return installApplication(app, {});
+}
+
+FlatpakJobTransaction * FlatpakBackend::watchInstallation(FlatpakJobTransaction *transaction, FlatpakResource *resource)
+{
     connect(transaction, &FlatpakJobTransaction::statusChanged, this, [this, resource] (Transaction::Status status) {
         if (status == Transaction::Status::DoneStatus) {
             updateAppState(resource);
@@ -1302,9 +1603,45 @@ Transaction* FlatpakBackend::installApplication(AbstractResource *app, const Add
     return transaction;
 }
 
-Transaction* FlatpakBackend::installApplication(AbstractResource *app)
+QVector<Transaction*> FlatpakBackend::installApplications(const QVector<AbstractResource*> &apps)
 {
-    return installApplication(app, {});
+    // Refs in the same installation go in a single flatpak transaction, so remotes are
+    // only pulled once and flatpak can order and share the runtimes they need
+    QVector<Transaction*> ret;
+    QHash<FlatpakInstallation*, QVector<FlatpakResource*>> batches;
+    for (auto app : apps) {
+        FlatpakResource *resource = qobject_cast<FlatpakResource*>(app);
+        if (resource->resourceType() == FlatpakResource::Source || resource->flatpakFileType() == QLatin1String("flatpak")) {
+            if (auto transaction = installApplication(app))
+                ret += transaction;
+        } else {
+            batches[resource->installation()] += resource;
+        }
+    }
+
+    for (const auto &batch : qAsConst(batches)) {
+        if (batch.size() == 1) {
+            ret += installApplication(batch.constFirst());
+            continue;
+        }
+
+        auto thread = new FlatpakTransactionThread(batch, Transaction::InstallRole);
+        QVector<Transaction*> transactions;
+        for (auto resource : batch) {
+            transactions += watchInstallation(new FlatpakJobTransaction(resource, Transaction::InstallRole, thread), resource);
+        }
+
+        // The batch is only reported once, not for every resource in it
+        Transaction *first = transactions.constFirst();
+        connect(thread, &FlatpakTransactionThread::speedChanged, first, &Transaction::setDownloadSpeed);
+        connect(thread, &FlatpakTransactionThread::passiveMessage, first, &Transaction::passiveMessage);
+        connect(thread, &FlatpakTransactionThread::finished, thread, &QObject::deleteLater);
+        QTimer::singleShot(0, thread, [thread] {
+            thread->start();
+        });
+        ret += transactions;
+    }
+    return ret;
 }
 
 Transaction* FlatpakBackend::removeApplication(AbstractResource *app)
@@ -1331,19 +1668,17 @@ Transaction* FlatpakBackend::removeApplication(AbstractResource *app)
 
 void FlatpakBackend::checkForUpdates()
 {
+    // Lets the notifier skip its own daily check, finished once the updates are loaded
+    m_refreshScheduler->start();
     for (auto installation : qAsConst(m_installations)) {
-        // Load local updates, comparing current and latest commit
-        loadLocalUpdates(installation);
-
         if (g_cancellable_is_cancelled(m_cancellable))
             break;
 
-        // Load updates from remote repositories
-        loadRemoteUpdates(installation);
-
-        if (g_cancellable_is_cancelled(m_cancellable))
-            break;
+        loadUpdates(installation);
     }
+
+    if (m_pendingUpdateLoads == 0)
+        m_refreshScheduler->finish(!g_cancellable_is_cancelled(m_cancellable));
 }
 
 QString FlatpakBackend::displayName() const
@@ -23,8 +23,12 @@ extern "C" {
 }
 
 class FlatpakSourcesBackend;
+class FlatpakRemoteRefsCache;
+class FlatpakJobTransaction;
 class StandardBackendUpdater;
 class OdrsReviewsBackend;
+class RefreshScheduler;
+class SearchIndex;
 class FlatpakBackend : public AbstractResourcesBackend
 {
     Q_OBJECT
@@ -45,6 +49,7 @@ public:
     Transaction* installApplication(AbstractResource* app) override;
     Transaction* installApplication(AbstractResource* app, const AddonList& addons) override;
     Transaction* removeApplication(AbstractResource* app) override;
+    QVector<Transaction*> installApplications(const QVector<AbstractResource*> &apps) override;
     bool isFetching() const override {
         return m_isFetching>0;
     }
@@ -68,17 +73,20 @@ public:
 
     bool updateAppSize(FlatpakResource *resource);
 
+
 private Q_SLOTS:
     void onFetchMetadataFinished(FlatpakResource *resource, const QByteArray &metadata);
     void onFetchSizeFinished(FlatpakResource *resource, guint64 downloadSize, guint64 installedSize);
     void onFetchUpdatesFinished(FlatpakInstallation *flatpakInstallation, GPtrArray *updates);
+    void remoteRefsChanged(FlatpakInstallation *installation, const QString &remote, const QStringList &refs);
 
 Q_SIGNALS: //for tests
     void initialized();
 
 private:
     void metadataRefreshed();
-    bool flatpakResourceLessThan(AbstractResource* l, AbstractResource* r) const;
+    /// Installed resources go first, then by origin and by @p relevance, their score in m_searchIndex
+    void sortByOriginRank(QVector<AbstractResource*> &resources, const QHash<AbstractResource*, double> &relevance = {}) const;
     void announceRatingsReady();
     FlatpakInstallation * preferredInstallation() const {
         return m_installations.constFirst();
@@ -89,10 +97,16 @@ private:
     FlatpakResource * getRuntimeForApp(FlatpakResource *resource) const;
 
     void addResource(FlatpakResource *resource);
+    void indexResource(FlatpakResource *resource);
+    void unindexResource(FlatpakResource *resource);
+    /// The name and the ids the resource is indexed by come from @p ref, so it's indexed again if it was already
+    void updateResourceFromRef(FlatpakResource *resource, FlatpakRef *ref);
+    QVector<FlatpakResource*> searchCandidates(const QString &search) const;
     void loadAppsFromAppstreamData();
-    bool loadAppsFromAppstreamData(FlatpakInstallation *flatpakInstallation);
+    void loadAppsFromAppstreamData(FlatpakInstallation *flatpakInstallation);
     void loadInstalledApps();
-    bool loadInstalledApps(FlatpakInstallation *flatpakInstallation);
+    void loadInstalledApps(FlatpakInstallation *flatpakInstallation);
+    void loadUpdates(FlatpakInstallation *flatpakInstallation);
     void loadLocalUpdates(FlatpakInstallation *flatpakInstallation);
     void loadRemoteUpdates(FlatpakInstallation *flatpakInstallation);
     bool parseMetadataFromAppBundle(FlatpakResource *resource);
@@ -104,11 +118,20 @@ private:
     bool updateAppMetadata(FlatpakResource *resource, const QString &path);
     bool updateAppSizeFromRemote(FlatpakResource *resource);
     void updateAppState(FlatpakResource *resource);
+    FlatpakJobTransaction * watchInstallation(FlatpakJobTransaction *transaction, FlatpakResource *resource);
 
     QVector<AbstractResource*> resourcesByAppstreamName(const QString &name) const;
     void acquireFetching(bool f);
 
     QHash<FlatpakResource::Id, FlatpakResource*> m_resources;
+    // case folded appstream ids and alternative ids
+    QHash<QString, QVector<FlatpakResource*>> m_resourcesByAppstreamId;
+    // trigrams of case folded name and comment, see textTrigrams()
+    QHash<quint64, QVector<FlatpakResource*>> m_textIndex;
+    // ranks what the trigrams find
+    SearchIndex* const m_searchIndex;
+    // runtimes by "id/branch", as referenced by the apps' metadata
+    QHash<QString, QVector<FlatpakResource*>> m_runtimes;
     StandardBackendUpdater  *m_updater;
     FlatpakSourcesBackend *m_sources = nullptr;
     QSharedPointer<OdrsReviewsBackend> m_reviews;
@@ -116,9 +139,21 @@ private:
     uint m_refreshAppstreamMetadataJobs;
     QStringList m_extends;
 
+    struct RemoteTiming {
+        qint64 refresh = -1;  ///< ms spent refreshing the appstream metadata, -1 if the cache was recent enough
+        qint64 parse = 0;     ///< ms spent parsing the appstream metadata on the thread pool
+        qint64 integrate = 0; ///< ms spent adding the resources on the main thread
+    };
+    // How long loading took for each remote, keyed by "installation-id/remote-name"
+    QHash<QString, RemoteTiming> m_remoteTimings;
+
     GCancellable *m_cancellable;
     QVector<FlatpakInstallation *> m_installations;
     QThreadPool m_threadPool;
+    FlatpakRemoteRefsCache *m_remoteRefs;
+    RefreshScheduler *const m_refreshScheduler;
+    int m_pendingUpdateLoads = 0;
+    bool m_updateLoadsFailed = false;
 };
 
 #endif // FLATPAKBACKEND_H
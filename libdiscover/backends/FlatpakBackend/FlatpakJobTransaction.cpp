@@ -28,11 +28,36 @@ FlatpakJobTransaction::FlatpakJobTransaction(FlatpakResource *app, Role role, bo
     }
 }
 
+FlatpakJobTransaction::FlatpakJobTransaction(FlatpakResource *app, Role role, FlatpakTransactionThread *batch)
+    : Transaction(app->backend(), app, role, {})
+    , m_app(app)
+    , m_appJob(batch)
+{
+    setCancellable(true);
+    setStatus(QueuedStatus);
+
+    connect(batch, &FlatpakTransactionThread::started, this, [this] {
+        setStatus(CommittingStatus);
+    });
+    connect(batch, &FlatpakTransactionThread::appProgressChanged, this, [this] (FlatpakResource *app, int progress) {
+        if (app == m_app)
+            setProgress(progress);
+    });
+    connect(batch, &FlatpakTransactionThread::finished, this, &FlatpakJobTransaction::finishTransaction);
+}
+
 FlatpakJobTransaction::~FlatpakJobTransaction() = default;
 
 void FlatpakJobTransaction::cancel()
 {
-    m_appJob->cancel();
+    // Cancelling any resource in a batch cancels all of them, they find out once the batch finishes
+    if (m_appJob && m_appJob->isBatch()) {
+        m_appJob->cancel();
+        return;
+    }
+
+    if (m_appJob)
+        m_appJob->cancel();
     setStatus(CancelledStatus);
 }
 
@@ -52,7 +77,9 @@ void FlatpakJobTransaction::start()
 
 void FlatpakJobTransaction::finishTransaction()
 {
-    if (m_appJob->result()) {
+    if (m_appJob->isBatch() && m_appJob->isCancelled() && !m_appJob->result(m_app)) {
+        setStatus(CancelledStatus);
+    } else if (m_appJob->result(m_app)) {
         AbstractResource::State newState = AbstractResource::None;
         switch (role()) {
         case InstallRole:
@@ -68,8 +95,9 @@ void FlatpakJobTransaction::finishTransaction()
 
         setStatus(DoneStatus);
     } else {
-        if (!m_appJob->errorMessage().isEmpty()) {
-            Q_EMIT passiveMessage(m_appJob->errorMessage());
+        const QString error = m_appJob->errorMessage(m_app);
+        if (!error.isEmpty()) {
+            Q_EMIT passiveMessage(error);
         }
         setStatus(DoneWithErrorStatus);
     }
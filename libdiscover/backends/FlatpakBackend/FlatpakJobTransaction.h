@@ -24,6 +24,8 @@ class FlatpakJobTransaction : public Transaction
     Q_OBJECT
 public:
     FlatpakJobTransaction(FlatpakResource *app, Role role, bool delayStart = false);
+    /// Tracks @p app within @p batch, which runs it together with other resources
+    FlatpakJobTransaction(FlatpakResource *app, Role role, FlatpakTransactionThread *batch);
 
     ~FlatpakJobTransaction();
 
@@ -6,6 +6,7 @@
  */
 
 #include "FlatpakNotifier.h"
+#include <RefreshScheduler.h>
 
 #include <glib.h>
 
@@ -34,10 +35,19 @@ FlatpakNotifier::FlatpakNotifier(QObject* parent)
     , m_user(this)
     , m_system(this)
     , m_cancellable(g_cancellable_new())
+    , m_refreshScheduler(new RefreshScheduler(QStringLiteral("Flatpak"), std::chrono::hours(24), this))
 {
+    connect(m_refreshScheduler, &RefreshScheduler::refreshed, this, &FlatpakNotifier::recheckSystemUpdateNeeded);
+
     QTimer *dailyCheck = new QTimer(this);
-    dailyCheck->setInterval(24 * 60 * 60 * 1000); //refresh at least once every day
-    connect(dailyCheck, &QTimer::timeout, this, &FlatpakNotifier::recheckSystemUpdateNeeded);
+    dailyCheck->setInterval(60 * 60 * 1000);
+    connect(dailyCheck, &QTimer::timeout, this, [this] {
+        //refresh at least once every day, unless Discover did already
+        if (m_refreshScheduler->startIfDue()) {
+            recheckSystemUpdateNeeded();
+        }
+    });
+    dailyCheck->start();
 }
 
 FlatpakNotifier::Installation::Installation(FlatpakNotifier *notifier)
@@ -65,6 +75,8 @@ void FlatpakNotifier::recheckSystemUpdateNeeded()
     // Load flatpak installation
     if (!setupFlatpakInstallations(&error)) {
         qWarning() << "Failed to setup flatpak installations: " << error->message;
+        if (m_pendingUpdateLoads == 0 && m_refreshScheduler->isRefreshing())
+            m_refreshScheduler->finish(false);
     } else {
         // Load updates from remote repositories
         loadRemoteUpdates(&m_system);
@@ -99,12 +111,21 @@ void FlatpakNotifier::onFetchUpdatesFinished(Installation *installation, GPtrArr
 
 void FlatpakNotifier::loadRemoteUpdates(Installation* installation)
 {
+    if (m_pendingUpdateLoads++ == 0)
+        m_updateLoadsFailed = false;
+
     auto fw = new QFutureWatcher<GPtrArray *>(this);
     connect(fw, &QFutureWatcher<GPtrArray *>::finished, this, [this, installation, fw]() {
         g_autoptr(GPtrArray) refs = fw->result();
         if (refs)
             onFetchUpdatesFinished(installation, refs);
+        else
+            m_updateLoadsFailed = true;
         fw->deleteLater();
+
+        // Listing the updates is what refreshes the remotes, it's only shared once they all answered
+        if (--m_pendingUpdateLoads == 0 && m_refreshScheduler->isRefreshing())
+            m_refreshScheduler->finish(!m_updateLoadsFailed);
     });
     fw->setFuture(QtConcurrent::run( [installation]() -> GPtrArray * {
         g_autoptr(GCancellable) cancellable = g_cancellable_new();
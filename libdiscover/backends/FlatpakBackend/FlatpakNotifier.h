@@ -14,6 +14,8 @@ extern "C" {
 #include <flatpak.h>
 }
 
+class RefreshScheduler;
+
 class FlatpakNotifier : public BackendNotifierModule
 {
     Q_OBJECT
@@ -50,6 +52,9 @@ public:
     Installation m_user;
     Installation m_system;
     GCancellable * const m_cancellable;
+    RefreshScheduler * const m_refreshScheduler;
+    int m_pendingUpdateLoads = 0;
+    bool m_updateLoadsFailed = false;
 };
 
 #endif
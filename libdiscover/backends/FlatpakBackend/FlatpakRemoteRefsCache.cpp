@@ -0,0 +1,239 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "FlatpakRemoteRefsCache.h"
+#include "FlatpakResource.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+// Bump whenever the stored data changes
+static const quint32 s_cacheVersion = 1;
+
+static QDataStream& operator<<(QDataStream &stream, const FlatpakRemoteRefInfo &info)
+{
+    return stream << info.downloadSize << info.installedSize << info.commit << info.runtime << info.metadata;
+}
+
+static QDataStream& operator>>(QDataStream &stream, FlatpakRemoteRefInfo &info)
+{
+    return stream >> info.downloadSize >> info.installedSize >> info.commit >> info.runtime >> info.metadata;
+}
+
+FlatpakRemoteRefsCache::FlatpakRemoteRefsCache(QThreadPool *threadPool, GCancellable *cancellable, QObject *parent)
+    : QObject(parent)
+    , m_threadPool(threadPool)
+    , m_cancellable(cancellable)
+{
+}
+
+void FlatpakRemoteRefsCache::fetch(FlatpakResource *resource, const Callback &callback)
+{
+    if (resource->origin().isEmpty()) {
+        qWarning() << "Failed to look up" << resource->ref() << "because of missing origin";
+        callback(nullptr);
+        return;
+    }
+
+    const RemoteKey key = { resource->installation(), resource->origin() };
+    auto& remote = m_remotes[key];
+    if (remote.listed) {
+        const Refs refs = remote.refs;
+        auto it = refs.constFind(resource->ref());
+        callback(it == refs.constEnd() ? nullptr : &*it);
+        return;
+    }
+
+    // Only the first query for a remote lists it, the rest wait for it
+    remote.pending.append({ resource, callback });
+    if (!remote.listing) {
+        listRemote(key, true);
+    }
+}
+
+void FlatpakRemoteRefsCache::invalidate(FlatpakInstallation *installation, const QString &remote)
+{
+    // Nothing was loaded, whatever is on disk is checked against the appstream timestamp
+    const RemoteKey key = { installation, remote };
+    auto it = m_remotes.find(key);
+    if (it == m_remotes.end())
+        return;
+
+    if (it->listing)
+        it->invalidated = true;
+    else
+        listRemote(key, false);
+}
+
+void FlatpakRemoteRefsCache::listRemote(const RemoteKey &key, bool load)
+{
+    m_remotes[key].listing = true;
+
+    auto fw = new QFutureWatcher<Listing>(this);
+    connect(fw, &QFutureWatcher<Listing>::finished, this, [this, fw, key]() {
+        fw->deleteLater();
+
+        const Listing listing = fw->result();
+        auto& remote = m_remotes[key];
+
+        QStringList changed;
+        if (remote.listed && listing.ok) {
+            for (auto it = listing.refs.constBegin(), itEnd = listing.refs.constEnd(); it != itEnd; ++it) {
+                auto old = remote.refs.constFind(it.key());
+                if (old != remote.refs.constEnd() && old->commit != it->commit)
+                    changed += it.key();
+            }
+        }
+
+        const auto pending = remote.pending;
+        const bool relist = remote.invalidated;
+        remote.pending.clear();
+        remote.listing = false;
+        remote.invalidated = false;
+
+        // An empty listing means the summary isn't cached yet, keep what we had and
+        // leave the remote unlisted so that the next query tries again
+        if (listing.ok && !listing.refs.isEmpty()) {
+            remote.listed = true;
+            remote.refs = listing.refs;
+            if (!listing.loaded)
+                QtConcurrent::run(m_threadPool, &FlatpakRemoteRefsCache::saveListing, cachePath(key), listing);
+        }
+
+        // Callbacks may query again, don't hold on to remote
+        const Refs refs = remote.refs;
+        for (const auto &query : pending) {
+            if (!query.first)
+                continue;
+
+            auto it = refs.constFind(query.first->ref());
+            query.second(it == refs.constEnd() ? nullptr : &*it);
+        }
+
+        if (!changed.isEmpty()) {
+            Q_EMIT refsChanged(key.first, key.second, changed);
+        }
+
+        if (relist) {
+            listRemote(key, false);
+        }
+    });
+    if (load)
+        fw->setFuture(QtConcurrent::run(m_threadPool, &FlatpakRemoteRefsCache::loadOrListRemoteRefs, cachePath(key), key.first, key.second, m_cancellable));
+    else
+        fw->setFuture(QtConcurrent::run(m_threadPool, &FlatpakRemoteRefsCache::listRemoteRefs, key.first, key.second, m_cancellable));
+}
+
+FlatpakRemoteRefsCache::Listing FlatpakRemoteRefsCache::loadOrListRemoteRefs(const QString &path, FlatpakInstallation *installation, const QString &remote, GCancellable *cancellable)
+{
+    const Listing listing = loadListing(path, installation, remote);
+    return listing.ok ? listing : listRemoteRefs(installation, remote, cancellable);
+}
+
+FlatpakRemoteRefsCache::Listing FlatpakRemoteRefsCache::loadListing(const QString &path, FlatpakInstallation *installation, const QString &remote)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    QDataStream stream(&file);
+    quint32 version = 0;
+    qint64 timestamp = -1;
+    stream >> version >> timestamp;
+    // The listing is only good as long as the remote wasn't refreshed after it
+    if (version != s_cacheVersion || timestamp < 0 || timestamp != appstreamTimestamp(installation, remote))
+        return {};
+
+    Listing ret;
+    stream >> ret.refs;
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Corrupt flatpak refs cache" << file.fileName();
+        return {};
+    }
+
+    ret.timestamp = timestamp;
+    ret.ok = true;
+    ret.loaded = true;
+    return ret;
+}
+
+void FlatpakRemoteRefsCache::saveListing(const QString &path, const Listing &listing)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write the flatpak refs cache" << path << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << s_cacheVersion << listing.timestamp << listing.refs;
+    file.commit();
+}
+
+qint64 FlatpakRemoteRefsCache::appstreamTimestamp(FlatpakInstallation *installation, const QString &remote)
+{
+    g_autoptr(FlatpakRemote) flatpakRemote = flatpak_installation_get_remote_by_name(installation, remote.toUtf8().constData(), nullptr, nullptr);
+    if (!flatpakRemote)
+        return -1;
+
+    g_autoptr(GFile) fileTimestamp = flatpak_remote_get_appstream_timestamp(flatpakRemote, flatpak_get_default_arch());
+    g_autofree char *path_str = g_file_get_path(fileTimestamp);
+    const QFileInfo fileInfo(QString::fromUtf8(path_str));
+    return fileInfo.exists() ? fileInfo.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+QString FlatpakRemoteRefsCache::cachePath(const RemoteKey &key)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/flatpak-refs/")
+         + QString::fromUtf8(flatpak_installation_get_id(key.first)) + QLatin1Char('-') + key.second;
+}
+
+FlatpakRemoteRefsCache::Listing FlatpakRemoteRefsCache::listRemoteRefs(FlatpakInstallation *installation, const QString &remote, GCancellable *cancellable)
+{
+    g_autoptr(GError) localError = nullptr;
+    g_autoptr(GPtrArray) remoteRefs = flatpak_installation_list_remote_refs_sync_full(installation, remote.toUtf8().constData(), FLATPAK_QUERY_FLAGS_ONLY_CACHED, cancellable, &localError);
+    if (!remoteRefs) {
+        qWarning() << "Failed to list refs of" << remote << (localError ? localError->message : "");
+        return {};
+    }
+
+    //We just find the runtime with a regex, QSettings only can read from disk (and so does KConfig)
+    const QRegularExpression rx(QStringLiteral("runtime=(.*)"));
+
+    Listing ret;
+    ret.ok = true;
+    ret.timestamp = appstreamTimestamp(installation, remote);
+    ret.refs.reserve(remoteRefs->len);
+    for (uint i = 0; i < remoteRefs->len; i++) {
+        FlatpakRemoteRef *remoteRef = FLATPAK_REMOTE_REF(g_ptr_array_index(remoteRefs, i));
+        g_autofree gchar *ref = flatpak_ref_format_ref(FLATPAK_REF(remoteRef));
+
+        FlatpakRemoteRefInfo info;
+        info.downloadSize = flatpak_remote_ref_get_download_size(remoteRef);
+        info.installedSize = flatpak_remote_ref_get_installed_size(remoteRef);
+        info.commit = QString::fromUtf8(flatpak_ref_get_commit(FLATPAK_REF(remoteRef)));
+        if (GBytes *metadata = flatpak_remote_ref_get_metadata(remoteRef)) {
+            gsize len = 0;
+            auto buff = g_bytes_get_data(metadata, &len);
+            info.metadata = QByteArray((const char*) buff, len);
+            info.runtime = rx.match(QString::fromUtf8(info.metadata)).captured(1);
+        }
+        ret.refs.insert(QString::fromUtf8(ref), info);
+    }
+    return ret;
+}
@@ -0,0 +1,108 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef FLATPAKREMOTEREFSCACHE_H
+#define FLATPAKREMOTEREFSCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+#include <functional>
+
+extern "C" {
+#include <flatpak.h>
+#include <glib.h>
+}
+
+class QThreadPool;
+class FlatpakResource;
+
+struct FlatpakRemoteRefInfo {
+    quint64 downloadSize = 0;
+    quint64 installedSize = 0;
+    QString commit;
+    /// runtime as found in the metadata, in the form of name/arch/branch
+    QString runtime;
+    QByteArray metadata;
+};
+
+/**
+ * Answers size and metadata queries for remote refs.
+ *
+ * Instead of looking up every ref on its own, the refs of a remote are listed
+ * once from the local summary cache and kept until the remote is invalidated,
+ * which should happen whenever its appstream metadata is refreshed.
+ *
+ * Listings are also stored on disk, so refs of remotes that haven't been
+ * refreshed since the last session are known without listing them again.
+ */
+class FlatpakRemoteRefsCache : public QObject
+{
+    Q_OBJECT
+public:
+    /** @p info is null if the ref couldn't be found in its remote */
+    typedef std::function<void(const FlatpakRemoteRefInfo *info)> Callback;
+
+    FlatpakRemoteRefsCache(QThreadPool *threadPool, GCancellable *cancellable, QObject *parent);
+
+    /**
+     * Calls @p callback with the information about @p resource in its origin,
+     * right away if the remote is listed already or once it's been listed.
+     *
+     * The callback won't be called if @p resource is destroyed meanwhile.
+     */
+    void fetch(FlatpakResource *resource, const Callback &callback);
+
+    /**
+     * Lists the refs of @p remote again.
+     *
+     * Queries keep being answered with the previous listing until it's done,
+     * and after it if listing again fails.
+     */
+    void invalidate(FlatpakInstallation *installation, const QString &remote);
+
+Q_SIGNALS:
+    /** Emitted when listing @p remote again found a different commit for @p refs */
+    void refsChanged(FlatpakInstallation *installation, const QString &remote, const QStringList &refs);
+
+private:
+    typedef QPair<FlatpakInstallation*, QString> RemoteKey;
+    typedef QHash<QString, FlatpakRemoteRefInfo> Refs;
+
+    struct Listing {
+        /// when the appstream metadata of the remote was last refreshed, in ms since epoch
+        qint64 timestamp = -1;
+        /// false if the remote couldn't be listed, refs are empty then
+        bool ok = false;
+        /// read from disk rather than listed, no need to store it again
+        bool loaded = false;
+        Refs refs;
+    };
+
+    struct Remote {
+        bool listed = false;
+        bool listing = false;
+        bool invalidated = false;
+        Refs refs;
+        QVector<QPair<QPointer<FlatpakResource>, Callback>> pending;
+    };
+
+    /** Lists @p key on the thread pool, taking the listing on disk if @p load and still valid */
+    void listRemote(const RemoteKey &key, bool load);
+    static Listing loadOrListRemoteRefs(const QString &path, FlatpakInstallation *installation, const QString &remote, GCancellable *cancellable);
+    static Listing loadListing(const QString &path, FlatpakInstallation *installation, const QString &remote);
+    static Listing listRemoteRefs(FlatpakInstallation *installation, const QString &remote, GCancellable *cancellable);
+    static void saveListing(const QString &path, const Listing &listing);
+    static qint64 appstreamTimestamp(FlatpakInstallation *installation, const QString &remote);
+    static QString cachePath(const RemoteKey &key);
+
+    QThreadPool *const m_threadPool;
+    GCancellable *const m_cancellable;
+    QHash<RemoteKey, Remote> m_remotes;
+};
+
+#endif // FLATPAKREMOTEREFSCACHE_H
@@ -33,7 +33,8 @@ progress_changed_cb (FlatpakTransactionProgress *progress,
 {
     FlatpakTransactionThread *obj = (FlatpakTransactionThread*) user_data;
 
-    obj->setProgress(qMin(99, flatpak_transaction_progress_get_progress(progress)));
+    const auto ref = static_cast<const char*>(g_object_get_data(G_OBJECT(progress), "discover-ref"));
+    obj->setOperationProgress(QString::fromUtf8(ref), flatpak_transaction_progress_get_progress(progress));
 
 #ifdef FLATPAK_VERBOSE_PROGRESS
     guint64 start_time = flatpak_transaction_progress_get_start_time (progress);
@@ -47,44 +48,88 @@ progress_changed_cb (FlatpakTransactionProgress *progress,
 
 void
 new_operation_cb(FlatpakTransaction          */*object*/,
-                 FlatpakTransactionOperation */*operation*/,
+                 FlatpakTransactionOperation *operation,
                  FlatpakTransactionProgress  *progress,
                  gpointer                     user_data)
 {
     FlatpakTransactionThread *obj = (FlatpakTransactionThread*) user_data;
 
-
+    // Batches need to know which ref the progress is about
+    g_object_set_data_full(G_OBJECT(progress), "discover-ref", g_strdup(flatpak_transaction_operation_get_ref(operation)), g_free);
     g_signal_connect (progress, "changed", G_CALLBACK (progress_changed_cb), obj);
     flatpak_transaction_progress_set_update_frequency (progress, FLATPAK_CLI_UPDATE_FREQUENCY);
 }
 
+gboolean
+ready_cb(FlatpakTransaction *transaction,
+         gpointer            user_data)
+{
+    FlatpakTransactionThread *obj = (FlatpakTransactionThread*) user_data;
+
+    QStringList refs;
+    GList *operations = flatpak_transaction_get_operations(transaction);
+    for (GList *l = operations; l; l = l->next) {
+        refs += QString::fromUtf8(flatpak_transaction_operation_get_ref(FLATPAK_TRANSACTION_OPERATION(l->data)));
+    }
+    g_list_free_full(operations, g_object_unref);
+
+    obj->setOperations(refs);
+    return true;
+}
+
 void
+operation_done_cb(FlatpakTransaction          */*object*/,
+                  FlatpakTransactionOperation *operation,
+                  const gchar                 */*commit*/,
+                  gint                         /*result*/,
+                  gpointer                     user_data)
+{
+    FlatpakTransactionThread *obj = (FlatpakTransactionThread*) user_data;
+    obj->operationDone(QString::fromUtf8(flatpak_transaction_operation_get_ref(operation)));
+}
+
+gboolean
 operation_error_cb(FlatpakTransaction          */*object*/,
-                   FlatpakTransactionOperation */*operation*/,
+                   FlatpakTransactionOperation *operation,
                    GError                      *error,
                    gint                         /*details*/,
                    gpointer                     user_data)
 {
     FlatpakTransactionThread *obj = (FlatpakTransactionThread*) user_data;
-    obj->addErrorMessage(QString::fromUtf8(error->message));
+    obj->operationFailed(QString::fromUtf8(flatpak_transaction_operation_get_ref(operation)), QString::fromUtf8(error->message));
+
+    // The rest of the refs in a batch shouldn't be held back by the one that failed
+    return obj->isBatch();
 }
 
 FlatpakTransactionThread::FlatpakTransactionThread(FlatpakResource *app, Transaction::Role role)
+    : FlatpakTransactionThread(QVector<FlatpakResource*>{ app }, role)
+{
+}
+
+FlatpakTransactionThread::FlatpakTransactionThread(const QVector<FlatpakResource*> &apps, Transaction::Role role)
     : QThread()
     , m_result(false)
-    , m_app(app)
+    , m_apps(apps)
     , m_role(role)
 {
+    Q_ASSERT(!apps.isEmpty());
+    for (auto app : apps) {
+        m_appsByRef.insert(app->ref(), app);
+    }
+
     m_cancellable = g_cancellable_new();
 
     g_autoptr(GError) localError = nullptr;
-    m_transaction = flatpak_transaction_new_for_installation(app->installation(), m_cancellable, &localError);
+    m_transaction = flatpak_transaction_new_for_installation(apps.constFirst()->installation(), m_cancellable, &localError);
     if (localError) {
         addErrorMessage(QString::fromUtf8(localError->message));
         qWarning() << "Failed to create transaction" << m_errorMessage;
     } else {
         g_signal_connect (m_transaction, "add-new-remote", G_CALLBACK (add_new_remote_cb), this);
+        g_signal_connect (m_transaction, "ready", G_CALLBACK (ready_cb), this);
         g_signal_connect (m_transaction, "new-operation", G_CALLBACK (new_operation_cb), this);
+        g_signal_connect (m_transaction, "operation-done", G_CALLBACK (operation_done_cb), this);
         g_signal_connect (m_transaction, "operation-error", G_CALLBACK (operation_error_cb), this);
     }
 }
@@ -100,57 +145,66 @@ void FlatpakTransactionThread::cancel()
     g_cancellable_cancel(m_cancellable);
 }
 
-void FlatpakTransactionThread::run()
+bool FlatpakTransactionThread::isCancelled() const
 {
-    if (!m_transaction)
-        return;
-    g_autoptr(GError) localError = nullptr;
+    return g_cancellable_is_cancelled(m_cancellable);
+}
 
-    const QString refName = m_app->ref();
+bool FlatpakTransactionThread::addOperation(FlatpakResource *app, GError **error)
+{
+    const QString refName = app->ref();
 
     if (m_role == Transaction::Role::InstallRole) {
-        bool correct = false;
-        if (m_app->state() == AbstractResource::Upgradeable && m_app->isInstalled()) {
-            correct = flatpak_transaction_add_update(m_transaction,
+        if (app->state() == AbstractResource::Upgradeable && app->isInstalled()) {
+            return flatpak_transaction_add_update(m_transaction,
                       refName.toUtf8().constData(),
-                      nullptr, nullptr, &localError);
-        } else {
-            if (m_app->flatpakFileType() == QLatin1String("flatpak")) {
-                g_autoptr(GFile) file = g_file_new_for_path(m_app->resourceFile().toLocalFile().toUtf8().constData());
-                if (!file) {
-                    qWarning() << "Failed to install bundled application" << refName;
-                    m_result = false;
-                    return;
-                }
-                correct = flatpak_transaction_add_install_bundle(m_transaction, file, nullptr, &localError);
-            } else {
-                correct = flatpak_transaction_add_install(m_transaction,
-                          m_app->origin().toUtf8().constData(),
-                          refName.toUtf8().constData(),
-                          nullptr,
-                          &localError);
+                      nullptr, nullptr, error);
+        } else if (app->flatpakFileType() == QLatin1String("flatpak")) {
+            g_autoptr(GFile) file = g_file_new_for_path(app->resourceFile().toLocalFile().toUtf8().constData());
+            if (!file) {
+                qWarning() << "Failed to install bundled application" << refName;
+                return false;
             }
-        }
-
-        if (!correct) {
-            m_result = false;
-            m_errorMessage = QString::fromUtf8(localError->message);
-            // We are done so we can set the progress to 100
-            setProgress(100);
-            qWarning() << "Failed to install" << refName << ':' << m_errorMessage;
-            return;
+            return flatpak_transaction_add_install_bundle(m_transaction, file, nullptr, error);
+        } else {
+            return flatpak_transaction_add_install(m_transaction,
+                      app->origin().toUtf8().constData(),
+                      refName.toUtf8().constData(),
+                      nullptr,
+                      error);
         }
     } else if (m_role == Transaction::Role::RemoveRole) {
-        if (!flatpak_transaction_add_uninstall(m_transaction,
-                                               refName.toUtf8().constData(),
-                                               &localError)) {
-            m_result = false;
-            m_errorMessage = QString::fromUtf8(localError->message);
-            // We are done so we can set the progress to 100
-            setProgress(100);
-            qWarning() << "Failed to uninstall" << refName << ':' << m_errorMessage;
-            return;
+        return flatpak_transaction_add_uninstall(m_transaction,
+                                                 refName.toUtf8().constData(),
+                                                 error);
+    }
+    return true;
+}
+
+void FlatpakTransactionThread::run()
+{
+    if (!m_transaction)
+        return;
+    g_autoptr(GError) localError = nullptr;
+
+    int added = 0;
+    for (auto app : m_apps) {
+        g_autoptr(GError) addError = nullptr;
+        if (addOperation(app, &addError)) {
+            ++added;
+            continue;
         }
+
+        const QString message = addError ? QString::fromUtf8(addError->message) : QString();
+        qWarning() << "Failed to add" << app->ref() << ':' << message;
+        operationFailed(app->ref(), message);
+    }
+
+    if (added == 0) {
+        m_result = false;
+        // We are done so we can set the progress to 100
+        setProgress(100);
+        return;
     }
 
     m_result = flatpak_transaction_run(m_transaction, m_cancellable, &localError);
@@ -172,7 +226,7 @@ void FlatpakTransactionThread::run()
                                                        strRef,
                                                        &localError))
                 {
-                    qDebug() << "failed to uninstall unused ref" << refName << localError->message;
+                    qDebug() << "failed to uninstall unused ref" << strRef << localError->message;
                     break;
                 }
             }
@@ -187,6 +241,71 @@ void FlatpakTransactionThread::run()
     setProgress(100);
 }
 
+void FlatpakTransactionThread::setOperations(const QStringList &refs)
+{
+    // Refs that aren't ours are runtimes and other dependencies pulled in by flatpak
+    for (const QString &ref : refs) {
+        if (!m_appsByRef.contains(ref))
+            m_dependencyProgress.insert(ref, 0);
+    }
+}
+
+void FlatpakTransactionThread::setOperationProgress(const QString &ref, int progress)
+{
+    if (!isBatch()) {
+        setProgress(qMin(99, progress));
+        return;
+    }
+
+    if (FlatpakResource *app = m_appsByRef.value(ref)) {
+        m_appProgress[app] = progress;
+    } else if (m_dependencyProgress.contains(ref)) {
+        m_dependencyProgress[ref] = progress;
+    } else {
+        return;
+    }
+    refreshAppsProgress();
+}
+
+void FlatpakTransactionThread::refreshAppsProgress()
+{
+    // We can't tell which resources need which dependency, so all of them wait on every one
+    int dependencies = 0;
+    for (int dependencyProgress : qAsConst(m_dependencyProgress))
+        dependencies += dependencyProgress;
+    const int parts = m_dependencyProgress.size() + 1;
+
+    int total = 0;
+    for (auto app : m_apps) {
+        const int appProgress = (dependencies + m_appProgress.value(app)) / parts;
+        total += appProgress;
+        Q_EMIT appProgressChanged(app, qMin(99, appProgress));
+    }
+    setProgress(qMin(99, total / m_apps.size()));
+}
+
+void FlatpakTransactionThread::operationDone(const QString &ref)
+{
+    if (FlatpakResource *app = m_appsByRef.value(ref)) {
+        m_done.insert(app);
+        m_appProgress[app] = 100;
+    } else if (m_dependencyProgress.contains(ref)) {
+        m_dependencyProgress[ref] = 100;
+    } else {
+        return;
+    }
+
+    if (isBatch())
+        refreshAppsProgress();
+}
+
+void FlatpakTransactionThread::operationFailed(const QString &ref, const QString &error)
+{
+    addErrorMessage(error);
+    if (FlatpakResource *app = m_appsByRef.value(ref))
+        m_errors.insert(app, error);
+}
+
 void FlatpakTransactionThread::setProgress(int progress)
 {
     Q_ASSERT(qBound(0, progress, 100) == progress);
@@ -214,6 +333,16 @@ bool FlatpakTransactionThread::result() const
     return m_result;
 }
 
+bool FlatpakTransactionThread::result(FlatpakResource *app) const
+{
+    return m_done.contains(app) || (m_result && !m_errors.contains(app));
+}
+
+QString FlatpakTransactionThread::errorMessage(FlatpakResource *app) const
+{
+    return m_errors.value(app, m_errorMessage);
+}
+
 void FlatpakTransactionThread::addErrorMessage(const QString &error)
 {
     if (!m_errorMessage.isEmpty())
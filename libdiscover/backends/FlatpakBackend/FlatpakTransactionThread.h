@@ -14,7 +14,11 @@ extern "C" {
 }
 
 #include <Transaction/Transaction.h>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QThread>
+#include <QVector>
 
 class FlatpakResource;
 class FlatpakTransactionThread : public QThread
@@ -22,9 +26,13 @@ class FlatpakTransactionThread : public QThread
     Q_OBJECT
 public:
     FlatpakTransactionThread(FlatpakResource *app, Transaction::Role role);
+    /// Runs @p role on all of @p apps in a single flatpak transaction, they must share their installation
+    FlatpakTransactionThread(const QVector<FlatpakResource*> &apps, Transaction::Role role);
     ~FlatpakTransactionThread() override;
 
+    /// A ref can't be dropped from a running flatpak transaction, this cancels it for all of the apps
     void cancel();
+    bool isCancelled() const;
     void run() override;
 
     int progress() const {
@@ -36,14 +44,30 @@ public:
     QString errorMessage() const;
     bool result() const;
 
+    /// @returns whether the operation on @p app succeeded, meaningful for batches once finished
+    bool result(FlatpakResource *app) const;
+    QString errorMessage(FlatpakResource *app) const;
+
+    bool isBatch() const {
+        return m_apps.size() > 1;
+    }
+
     void addErrorMessage(const QString &error);
+    void setOperations(const QStringList &refs);
+    void setOperationProgress(const QString &ref, int progress);
+    void operationDone(const QString &ref);
+    void operationFailed(const QString &ref, const QString &error);
 
 Q_SIGNALS:
     void progressChanged(int progress);
+    void appProgressChanged(FlatpakResource *app, int progress);
     void speedChanged(quint64 speed);
     void passiveMessage(const QString &msg);
 
 private:
+    bool addOperation(FlatpakResource *app, GError **error);
+    void refreshAppsProgress();
+
     FlatpakTransaction* m_transaction;
 
     bool m_result = false;
@@ -51,8 +75,15 @@ private:
     quint64 m_speed = 0;
     QString m_errorMessage;
     GCancellable *m_cancellable;
-    FlatpakResource * const m_app;
+    const QVector<FlatpakResource*> m_apps;
     const Transaction::Role m_role;
+    QHash<QString, FlatpakResource*> m_appsByRef;
+
+    // Filled while the thread runs, only read once it's finished
+    QHash<FlatpakResource*, int> m_appProgress;
+    QHash<QString, int> m_dependencyProgress;
+    QSet<FlatpakResource*> m_done;
+    QHash<FlatpakResource*, QString> m_errors;
 };
 
 #endif // FLATPAKTRANSACTIONJOB_H
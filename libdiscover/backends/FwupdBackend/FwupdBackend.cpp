@@ -9,11 +9,15 @@
 #include "FwupdResource.h"
 #include "FwupdTransaction.h"
 #include "FwupdSourcesBackend.h"
+#include "FwupdChecksumService.h"
 #include <resources/StandardBackendUpdater.h>
 #include <resources/SourcesModel.h>
 #include <Transaction/Transaction.h>
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 #include <KAboutData>
 #include <KLocalizedString>
 #include <KPluginFactory>
@@ -27,6 +31,7 @@ FwupdBackend::FwupdBackend(QObject* parent)
     , client(fwupd_client_new())
     , m_updater(new StandardBackendUpdater(this))
     , m_cancellable(g_cancellable_new())
+    , m_checksums(new FwupdChecksumService(this))
 {
     fwupd_client_set_user_agent_for_package(client, "plasma-discover", "1.0");
     connect(m_updater, &StandardBackendUpdater::updatesCountChanged, this, &FwupdBackend::updatesCountChanged);
@@ -50,7 +55,12 @@ QMap<GChecksumType, QCryptographicHash::Algorithm> FwupdBackend::gchecksumToQChr
 FwupdBackend::~FwupdBackend()
 {
     g_cancellable_cancel(m_cancellable);
+    m_threadPool.waitForDone();
     g_object_unref(m_cancellable);
+    // The devices of a check that didn't get to finish are never set
+    if (m_devicesWatcher) {
+        freeDevices(m_devicesWatcher->result());
+    }
 
     g_object_unref(client);
 }
@@ -83,81 +93,70 @@ FwupdResource * FwupdBackend::createRelease(FwupdDevice *device)
 
 }
 
-void FwupdBackend::addUpdates()
+void FwupdBackend::addUpdate(const DeviceInfo &info)
 {
-    g_autoptr(GError) error = nullptr;
-    g_autoptr(GPtrArray) devices = fwupd_client_get_devices(client, m_cancellable, &error);
+    FwupdDevice *device = info.device;
+    if (!info.upgrades || !fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE) || fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_LOCKED))
+        return;
 
-    if (!devices)
+    GPtrArray *rels = info.upgrades;
+    fwupd_device_add_release(device, (FwupdRelease *)g_ptr_array_index(rels, 0));
+    auto res = createApp(device);
+    if (!res)
     {
-        if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO))
-            qDebug() << "Fwupd Info: No Devices Found";
-        else
-            handleError(error);
+        qWarning() << "Fwupd Error: Cannot Create App From Device" << fwupd_device_get_name(device);
         return;
     }
 
-    for (uint i = 0; i < devices->len && !g_cancellable_is_cancelled(m_cancellable); i++)
+    QString longdescription;
+    for (uint j = 0; j < rels->len; j++)
     {
-        FwupdDevice *device = (FwupdDevice *)g_ptr_array_index(devices, i);
-
-        if (!fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_SUPPORTED))
+        FwupdRelease *release = (FwupdRelease *)g_ptr_array_index(rels, j);
+        if (!fwupd_release_get_description(release))
             continue;
-
-        if (fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_LOCKED))
-            continue;
-
-        if (!fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE))
-            continue;
-
-        g_autoptr(GError) error2 = nullptr;
-        g_autoptr(GPtrArray) rels = fwupd_client_get_upgrades(client, fwupd_device_get_id(device), m_cancellable, &error2);
-        if (rels) {
-            fwupd_device_add_release(device, (FwupdRelease *)g_ptr_array_index(rels, 0));
-            auto res = createApp(device);
-            if (!res)
-            {
-                qWarning() << "Fwupd Error: Cannot Create App From Device" << fwupd_device_get_name(device);
-            }
-            else
-            {
-                QString longdescription;
-                for (uint j = 0; j < rels->len; j++)
-                {
-                    FwupdRelease *release = (FwupdRelease *)g_ptr_array_index(rels, j);
-                    if (!fwupd_release_get_description(release))
-                        continue;
-                    longdescription += QStringLiteral("Version %1\n").arg(QString::fromUtf8(fwupd_release_get_version(release)));
-                    longdescription += QString::fromUtf8(fwupd_release_get_description(release)) + QLatin1Char('\n');
-                }
-                res->setDescription(longdescription);
-                addResource(res);
-            }
-        } else {
-            if (g_error_matches(error2, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-                qWarning() << "fwupd: Device not supported:" << fwupd_device_get_name(device);
-            } else if (!g_error_matches(error2, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO)) {
-                handleError(error2);
-            }
-        }
+        longdescription += QStringLiteral("Version %1\n").arg(QString::fromUtf8(fwupd_release_get_version(release)));
+        longdescription += QString::fromUtf8(fwupd_release_get_description(release)) + QLatin1Char('\n');
     }
+    res->setDescription(longdescription);
+    addResource(res);
 }
 
-QByteArray FwupdBackend::getChecksum(const QString &filename, QCryptographicHash::Algorithm hashAlgorithm)
+QMap<QCryptographicHash::Algorithm, QByteArray> FwupdBackend::expectedChecksums(GPtrArray *checksums)
 {
-    QFile f(filename);
-    if (!f.open(QFile::ReadOnly)) {
-        qWarning() << "could not open to check" << filename;
-        return {};
+    // Check every checksum the release offers, they are all computed in the same pass
+    const auto algorithms = gchecksumToQChryptographicHash();
+    QMap<QCryptographicHash::Algorithm, QByteArray> expected;
+    for (auto it = algorithms.constBegin(); it != algorithms.constEnd(); ++it) {
+        const gchar *checksum = fwupd_checksum_get_by_kind(checksums, it.key());
+        if (checksum) {
+            expected.insert(it.value(), QByteArray(checksum).toLower());
+        }
     }
+    return expected;
+}
 
-    QCryptographicHash hash(hashAlgorithm);
-    if (!hash.addData(&f)) {
-        qWarning() << "could not read to check" << filename;
-        return {};
+void FwupdBackend::validateCacheFile(const QString &fileName, const std::function<void(bool valid)> &callback)
+{
+    const auto expected = m_expectedChecksums.value(fileName);
+    if (expected.isEmpty()) {
+        qWarning() << "Fwupd: removing cached firmware without a known checksum" << fileName;
+        QFile::remove(fileName);
+        callback(false);
+        return;
     }
 
-    return hash.result().toHex();
+    m_checksums->checksums(fileName, expected.keys().toVector(), [fileName, expected, callback] (const FwupdChecksumService::Checksums &checksums) {
+        // The service may hand out more checksums than the release has, only compare the ones it has
+        bool valid = true;
+        for (auto it = expected.constBegin(); it != expected.constEnd() && valid; ++it) {
+            valid = checksums.value(it.key()) == it.value();
+        }
+        if (!valid) {
+            qWarning() << "Fwupd: removing cached firmware with a wrong checksum" << fileName;
+            QFile::remove(fileName);
+        }
+        callback(valid);
+    });
 }
 
 FwupdResource* FwupdBackend::createApp(FwupdDevice *device)
@@ -194,13 +193,9 @@ FwupdResource* FwupdBackend::createApp(FwupdDevice *device)
 
     /* Checking for firmware in the cache? */
     const QString filename_cache = app->cacheFile();
+    m_expectedChecksums.insert(filename_cache, expectedChecksums(checksums));
     if (QFile::exists(filename_cache)) {
-        /* Currently LVFS supports SHA1 only*/
-        const QByteArray checksum_tmp(fwupd_checksum_get_by_kind(checksums, G_CHECKSUM_SHA1));
-        const QByteArray checksum = getChecksum(filename_cache, QCryptographicHash::Sha1);
-        if (checksum_tmp != checksum) {
-            QFile::remove(filename_cache);
-        }
+        validateCacheFile(filename_cache, [] (bool) {});
     }
 
     app->setState(AbstractResource::Upgradeable);
@@ -235,43 +230,91 @@ QString FwupdBackend::cacheFile(const QString &kind, const QString &basename)
     return cacheDir.filePath(kind + QLatin1Char('/') + basename);
 }
 
-static void fwupd_client_get_devices_cb (GObject */*source*/, GAsyncResult *res, gpointer user_data)
+// Runs on a worker thread, queries every device for its releases and upgrades
+FwupdBackend::Devices FwupdBackend::fetchDevices(GCancellable *cancellable)
 {
-    FwupdBackend *helper = (FwupdBackend *) user_data;
-    g_autoptr(GError) error = nullptr;
-    auto array = fwupd_client_get_devices_finish(helper->client, res, &error);
-    if (!error)
-        helper->setDevices(array);
-    else
-        helper->handleError(error);
-}
+    Devices ret;
+    GError *error = nullptr;
 
-void FwupdBackend::setDevices(GPtrArray *devices)
-{
-    for (uint i = 0; devices && i < devices->len; i++) {
+    // FwupdClient isn't thread safe and the backend's is used on the main thread meanwhile
+    g_autoptr(FwupdClient) client = fwupd_client_new();
+    fwupd_client_set_user_agent_for_package(client, "plasma-discover", "1.0");
+    if (!fwupd_client_connect(client, cancellable, &error)) {
+        ret.errors += error;
+        return ret;
+    }
+
+    g_autoptr(GPtrArray) devices = fwupd_client_get_devices(client, cancellable, &error);
+    if (!devices) {
+        if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO)) {
+            qDebug() << "Fwupd Info: No Devices Found";
+            g_error_free(error);
+        } else {
+            ret.errors += error;
+        }
+        return ret;
+    }
+
+    for (uint i = 0; i < devices->len && !g_cancellable_is_cancelled(cancellable); i++) {
         FwupdDevice *device = (FwupdDevice *) g_ptr_array_index(devices, i);
 
         if (!fwupd_device_has_flag (device, FWUPD_DEVICE_FLAG_SUPPORTED))
             continue;
 
-        g_autoptr(GError) error = nullptr;
-        g_autoptr(GPtrArray) releases = fwupd_client_get_releases(client, fwupd_device_get_id(device), m_cancellable, &error);
+        QElapsedTimer timer;
+        timer.start();
 
-        if (error) {
-            if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-                qWarning() << "fwupd: Device not supported:" << fwupd_device_get_name(device) << error->message;
+        DeviceInfo info;
+        GError *releasesError = nullptr;
+        info.releases = fwupd_client_get_releases(client, fwupd_device_get_id(device), cancellable, &releasesError);
+        if (releasesError) {
+            if (g_error_matches(releasesError, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+                qWarning() << "fwupd: Device not supported:" << fwupd_device_get_name(device) << releasesError->message;
+                g_error_free(releasesError);
                 continue;
             }
-            if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
+            if (g_error_matches(releasesError, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
+                g_error_free(releasesError);
                 continue;
             }
+            ret.errors += releasesError;
+        }
 
-            handleError(error);
+        if (fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE) && !fwupd_device_has_flag(device, FWUPD_DEVICE_FLAG_LOCKED)) {
+            GError *upgradesError = nullptr;
+            info.upgrades = fwupd_client_get_upgrades(client, fwupd_device_get_id(device), cancellable, &upgradesError);
+            if (upgradesError) {
+                if (g_error_matches(upgradesError, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+                    qWarning() << "fwupd: Device not supported:" << fwupd_device_get_name(device);
+                    g_error_free(upgradesError);
+                } else if (g_error_matches(upgradesError, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO)) {
+                    g_error_free(upgradesError);
+                } else {
+                    ret.errors += upgradesError;
+                }
+            }
         }
 
-        auto res = new FwupdResource(device, this);
-        for (uint i=0; releases && i<releases->len; ++i) {
-            FwupdRelease *release = (FwupdRelease *)g_ptr_array_index(releases, i);
+        info.device = FWUPD_DEVICE(g_object_ref(device));
+        info.elapsed = timer.elapsed();
+        ret.devices += info;
+    }
+    return ret;
+}
+
+void FwupdBackend::setDevices(const Devices &devices)
+{
+    for (GError *error : devices.errors) {
+        handleError(error);
+    }
+
+    m_deviceTimings.clear();
+    for (const DeviceInfo &info : devices.devices) {
+        m_deviceTimings.insert(QString::fromUtf8(fwupd_device_get_id(info.device)), info.elapsed);
+
+        auto res = new FwupdResource(info.device, this);
+        for (uint i=0; info.releases && i<info.releases->len; ++i) {
+            FwupdRelease *release = (FwupdRelease *)g_ptr_array_index(info.releases, i);
             if (res->installedVersion().toUtf8() == fwupd_release_get_version(release)) {
                 res->setReleaseDetails(release);
                 break;
@@ -279,15 +322,32 @@ void FwupdBackend::setDevices(GPtrArray *devices)
         }
         addResource(res);
     }
-    g_ptr_array_unref(devices);
 
-    addUpdates();
+    // Upgrades replace the installed version of the device they are for
+    for (const DeviceInfo &info : devices.devices) {
+        addUpdate(info);
+    }
+    freeDevices(devices);
 
     m_fetching = false;
     emit fetchingChanged();
     emit initialized();
 }
 
+void FwupdBackend::freeDevices(const Devices &devices)
+{
+    for (GError *error : devices.errors) {
+        g_error_free(error);
+    }
+    for (const DeviceInfo &info : devices.devices) {
+        if (info.releases)
+            g_ptr_array_unref(info.releases);
+        if (info.upgrades)
+            g_ptr_array_unref(info.upgrades);
+        g_object_unref(info.device);
+    }
+}
+
 static void fwupd_client_get_remotes_cb (GObject */*source*/, GAsyncResult *res, gpointer user_data)
 {
     FwupdBackend *helper = (FwupdBackend *) user_data;
@@ -338,7 +398,14 @@ void FwupdBackend::checkForUpdates()
     m_fetching = true;
     emit fetchingChanged();
 
-    fwupd_client_get_devices_async(client, m_cancellable, fwupd_client_get_devices_cb, this);
+    m_devicesWatcher = new QFutureWatcher<Devices>(this);
+    connect(m_devicesWatcher, &QFutureWatcher<Devices>::finished, this, [this] {
+        auto fw = m_devicesWatcher;
+        m_devicesWatcher = nullptr;
+        setDevices(fw->result());
+        fw->deleteLater();
+    });
+    m_devicesWatcher->setFuture(QtConcurrent::run(&m_threadPool, &FwupdBackend::fetchDevices, m_cancellable));
     fwupd_client_get_remotes_async(client, m_cancellable, fwupd_client_get_remotes_cb, this);
 }
 
@@ -24,6 +24,9 @@
 #include <QNetworkRequest>
 #include <QCryptographicHash>
 #include <QMap>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <functional>
 
 extern "C" {
 #include <fwupd.h>
@@ -33,6 +36,7 @@ extern "C" {
 class QAction;
 class StandardBackendUpdater;
 class FwupdResource;
+class FwupdChecksumService;
 class FwupdBackend : public AbstractResourcesBackend
 {
     Q_OBJECT
@@ -45,6 +49,9 @@ public:
     AbstractBackendUpdater* backendUpdater() const override;
     AbstractReviewsBackend* reviewsBackend() const override;
     ResultsStream* search(const AbstractResourcesBackend::Filters & search) override;
+    bool isSearchPrefixMonotonic() const override {
+        return true;
+    }
     ResultsStream * findResourceByPackageName(const QUrl& search) ;
     QHash<QString, FwupdResource*> resources() const {
         return m_resources;
@@ -66,22 +73,49 @@ public:
     void handleError(GError *perror);
 
     static QString cacheFile(const QString &kind, const QString &baseName);
-    void setDevices(GPtrArray*);
     void setRemotes(GPtrArray*);
 
+    /**
+     * Checks the firmware cached at @p fileName against the checksums of the release it's for,
+     * removing it if it doesn't match. @p callback is told whether it can be installed.
+     */
+    void validateCacheFile(const QString &fileName, const std::function<void(bool valid)> &callback);
+    FwupdChecksumService* checksumService() const {
+        return m_checksums;
+    }
+
+    /// How long it took to query each device for its releases and upgrades on the last check, in milliseconds, by device id
+    QHash<QString, qint64> deviceTimings() const {
+        return m_deviceTimings;
+    }
+
+    struct DeviceInfo {
+        FwupdDevice *device = nullptr;
+        GPtrArray *releases = nullptr;
+        GPtrArray *upgrades = nullptr;
+        qint64 elapsed = 0;
+    };
+    struct Devices {
+        QVector<DeviceInfo> devices;
+        QVector<GError*> errors;
+    };
+
 Q_SIGNALS:
     void initialized();
 
 private:
     ResultsStream* resourceForFile(const QUrl & );
     void refreshRemotes();
-    void addUpdates();
+    void setDevices(const Devices &devices);
+    void addUpdate(const DeviceInfo &info);
+    static Devices fetchDevices(GCancellable *cancellable);
+    static void freeDevices(const Devices &devices);
     void addResource(FwupdResource *res);
     QSet<AbstractResource*> getAllUpdates();
 
     static QMap<GChecksumType,QCryptographicHash::Algorithm> gchecksumToQChryptographicHash();
     static void refreshRemote(FwupdBackend* backend, FwupdRemote *remote, quint64 cacheAge, GCancellable *cancellable);
-    static QByteArray getChecksum(const QString &filename, QCryptographicHash::Algorithm hashAlgorithm);
+    static QMap<QCryptographicHash::Algorithm, QByteArray> expectedChecksums(GPtrArray *checksums);
 
     FwupdResource * createRelease(FwupdDevice *device);
     FwupdResource * createApp(FwupdDevice *device);
@@ -92,6 +126,12 @@ private:
     int m_startElements;
     QList<AbstractResource*> m_toUpdate;
     GCancellable *m_cancellable;
+    FwupdChecksumService* const m_checksums;
+    // Checksums of the releases, by the file they are downloaded to
+    QHash<QString, QMap<QCryptographicHash::Algorithm, QByteArray>> m_expectedChecksums;
+    QHash<QString, qint64> m_deviceTimings;
+    QFutureWatcher<Devices>* m_devicesWatcher = nullptr;
+    QThreadPool m_threadPool;
 };
 
 #endif // FWUPDBACKEND_H
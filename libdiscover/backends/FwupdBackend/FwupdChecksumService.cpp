@@ -0,0 +1,102 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "FwupdChecksumService.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <algorithm>
+#include <memory>
+
+static const qint64 s_chunkSize = 1024 * 1024;
+
+FwupdChecksumService::FwupdChecksumService(QObject* parent)
+    : QObject(parent)
+    , m_cancelled(false)
+{
+    m_threadPool.setMaxThreadCount(1);
+}
+
+FwupdChecksumService::~FwupdChecksumService()
+{
+    m_cancelled = true;
+    m_threadPool.waitForDone();
+}
+
+FwupdChecksumService::Checksums FwupdChecksumService::compute(FwupdChecksumService* service, const QString &path, const QVector<QCryptographicHash::Algorithm> &algorithms)
+{
+    QFile f(path);
+    if (!f.open(QFile::ReadOnly)) {
+        qWarning() << "could not open to check" << path;
+        return {};
+    }
+
+    std::vector<std::unique_ptr<QCryptographicHash>> hashes;
+    for (auto algorithm : algorithms) {
+        hashes.emplace_back(new QCryptographicHash(algorithm));
+    }
+
+    const qint64 total = f.size();
+    qint64 done = 0;
+    int lastPercentage = -1;
+    QByteArray chunk(s_chunkSize, Qt::Uninitialized);
+    while (!f.atEnd()) {
+        if (service->m_cancelled) {
+            return {};
+        }
+
+        const qint64 read = f.read(chunk.data(), chunk.size());
+        if (read < 0) {
+            qWarning() << "could not read to check" << path << f.errorString();
+            return {};
+        }
+        for (const auto &hash : hashes) {
+            hash->addData(chunk.constData(), read);
+        }
+
+        done += read;
+        const int percentage = total > 0 ? int(done * 100 / total) : 100;
+        if (percentage != lastPercentage) {
+            lastPercentage = percentage;
+            Q_EMIT service->progress(path, percentage);
+        }
+    }
+
+    Checksums ret;
+    for (int i = 0; i < algorithms.size(); ++i) {
+        ret.insert(algorithms[i], hashes[i]->result().toHex());
+    }
+    return ret;
+}
+
+void FwupdChecksumService::checksums(const QString &path, const QVector<QCryptographicHash::Algorithm> &algorithms, const Callback &callback)
+{
+    const QFileInfo info(path);
+    const auto it = m_cache.constFind(path);
+    if (it != m_cache.constEnd() && it->modified == info.lastModified() && it->size == info.size()) {
+        const bool complete = std::all_of(algorithms.constBegin(), algorithms.constEnd(), [&it] (QCryptographicHash::Algorithm algorithm) {
+            return it->checksums.contains(algorithm);
+        });
+        if (complete) {
+            callback(it->checksums);
+            return;
+        }
+    }
+
+    auto fw = new QFutureWatcher<Checksums>(this);
+    connect(fw, &QFutureWatcher<Checksums>::finished, this, [this, fw, path, info, callback] {
+        const Checksums result = fw->result();
+        fw->deleteLater();
+        if (!result.isEmpty()) {
+            m_cache.insert(path, { info.lastModified(), info.size(), result });
+        }
+        callback(result);
+    });
+    fw->setFuture(QtConcurrent::run(&m_threadPool, &FwupdChecksumService::compute, this, path, algorithms));
+}
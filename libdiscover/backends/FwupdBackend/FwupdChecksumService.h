@@ -0,0 +1,61 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef FWUPDCHECKSUMSERVICE_H
+#define FWUPDCHECKSUMSERVICE_H
+
+#include <QObject>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+/**
+ * Computes file checksums on a worker thread.
+ *
+ * All the requested algorithms are computed in the same pass over the file
+ * and the results are kept for as long as the file's size and modification
+ * time don't change.
+ */
+class FwupdChecksumService : public QObject
+{
+    Q_OBJECT
+public:
+    typedef QMap<QCryptographicHash::Algorithm, QByteArray> Checksums;
+    typedef std::function<void(const Checksums &checksums)> Callback;
+
+    explicit FwupdChecksumService(QObject* parent = nullptr);
+    ~FwupdChecksumService() override;
+
+    /**
+     * Calls @p callback with the hex encoded checksums of @p path for every one of the @p algorithms.
+     * The checksums are empty if the file could not be read.
+     */
+    void checksums(const QString &path, const QVector<QCryptographicHash::Algorithm> &algorithms, const Callback &callback);
+
+Q_SIGNALS:
+    /// Emitted from the worker thread while hashing @p path
+    void progress(const QString &path, int percentage);
+
+private:
+    struct CachedChecksums {
+        QDateTime modified;
+        qint64 size;
+        Checksums checksums;
+    };
+
+    static Checksums compute(FwupdChecksumService* service, const QString &path, const QVector<QCryptographicHash::Algorithm> &algorithms);
+
+    QHash<QString, CachedChecksums> m_cache;
+    QThreadPool m_threadPool;
+    std::atomic<bool> m_cancelled;
+};
+
+#endif // FWUPDCHECKSUMSERVICE_H
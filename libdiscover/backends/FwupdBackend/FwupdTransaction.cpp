@@ -6,7 +6,9 @@
  */
 
 #include "FwupdTransaction.h"
+#include "FwupdChecksumService.h"
 
+#include <QPointer>
 #include <QTimer>
 
 FwupdTransaction::FwupdTransaction(FwupdResource* app, FwupdBackend* backend)
@@ -62,7 +64,7 @@ void FwupdTransaction::install()
                 file->remove();
                 setStatus(DoneWithErrorStatus);
             } else {
-                fwupdInstall(file->fileName());
+                validateAndInstall(file->fileName(), true);
             }
         });
         connect(reply, &QNetworkReply::readyRead, this, [file, reply]() {
@@ -71,10 +73,37 @@ void FwupdTransaction::install()
     }
     else
     {
-        fwupdInstall(fileName);
+        validateAndInstall(fileName, false);
     }
 }
 
+void FwupdTransaction::validateAndInstall(const QString &file, bool downloaded)
+{
+    // fwupd doesn't get the file until it's been checked
+    setStatus(CommittingStatus);
+    const auto progress = connect(m_backend->checksumService(), &FwupdChecksumService::progress, this, [this, file] (const QString &path, int percentage) {
+        if (path == file)
+            setProgress(percentage);
+    });
+
+    QPointer<FwupdTransaction> guard = this;
+    m_backend->validateCacheFile(file, [guard, file, downloaded, progress] (bool valid) {
+        QObject::disconnect(progress);
+        if (!guard || guard->status() == CancelledStatus)
+            return;
+
+        if (valid) {
+            guard->fwupdInstall(file);
+        } else if (!downloaded) {
+            // The broken file is gone, download it again
+            guard->install();
+        } else {
+            qWarning() << "Fwupd Error: Downloaded firmware does not match its checksum" << file;
+            guard->setStatus(DoneWithErrorStatus);
+        }
+    });
+}
+
 void FwupdTransaction::fwupdInstall(const QString &file)
 {
     FwupdInstallFlags install_flags = FWUPD_INSTALL_FLAG_NONE;
@@ -30,6 +30,8 @@ private Q_SLOTS:
 
 private:
     void install();
+    /// Installs @p file once it's been checked, @p downloaded tells whether it was just downloaded
+    void validateAndInstall(const QString &file, bool downloaded);
 
     FwupdResource* const m_app;
     FwupdBackend* const m_backend;
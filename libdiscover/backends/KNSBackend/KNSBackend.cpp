@@ -75,6 +75,10 @@ public:
 
 Q_DECLARE_METATYPE(KNSCore::EntryInternal)
 
+// How many search pages we keep around, and for how long they are considered valid
+static const int s_searchCacheSize = 64;
+static const int s_searchCacheTtl = 15 * 60;
+
 KNSBackend::KNSBackend(QObject* parent, const QString& iconName, const QString &knsrc)
     : AbstractResourcesBackend(parent)
     , m_fetching(false)
@@ -83,6 +87,7 @@ KNSBackend::KNSBackend(QObject* parent, const QString& iconName, const QString &
     , m_name(knsrc)
     , m_iconName(iconName)
     , m_updater(new StandardBackendUpdater(this))
+    , m_searchCache(s_searchCacheSize)
 {
     const QString fileName = QFileInfo(m_name).fileName();
     setName(fileName);
@@ -106,6 +111,10 @@ KNSBackend::KNSBackend(QObject* parent, const QString& iconName, const QString &
     connect(this, &KNSBackend::initialized, this, [this]() {
         m_initialized = true;
     });
+    // Anything else the engine is asked to do stops feeding the current search
+    connect(this, &KNSBackend::startingSearch, this, [this]() {
+        m_searchRequestPending = false;
+    });
     // If we have not initialized in 60 seconds, consider this KNS backend invalid
     QTimer::singleShot(60000, this, [this]() {
         if (!m_initialized) {
@@ -158,8 +167,10 @@ KNSBackend::KNSBackend(QObject* parent, const QString& iconName, const QString &
         m_responsePending = false;
         Q_EMIT availableForQueries();
     });
-    connect(m_engine, &KNSCore::Engine::signalCategoriesMetadataLoded, this, [categories] (const QList<KNSCore::Provider::CategoryMetadata>& categoryMetadatas) {
+    connect(m_engine, &KNSCore::Engine::signalCategoriesMetadataLoded, this, [this, categories] (const QList<KNSCore::Provider::CategoryMetadata>& categoryMetadatas) {
+        m_categoryNames.clear();
         for (const KNSCore::Provider::CategoryMetadata& category : categoryMetadatas) {
+            m_categoryNames.insert(category.id, category.name);
             for (Category* cat : qAsConst(categories)) {
                 if (cat->orFilters().count() > 0 && cat->orFilters().constFirst().second == category.name) {
                     cat->setName(category.displayName);
@@ -300,12 +311,15 @@ KNSResource* KNSBackend::resourceForEntry(const KNSCore::EntryInternal& entry)
     KNSResource* r = static_cast<KNSResource*>(m_resourcesByName.value(entry.uniqueId()));
     if (!r) {
         QStringList categories{name(), m_rootCategories.first()->name()};
-        const auto cats = m_engine->categoriesMetadata();
-        const int catIndex = kIndexOf(cats, [&entry](const KNSCore::Provider::CategoryMetadata& cat) {
-            return entry.category() == cat.id;
-        });
-        if (catIndex > -1) {
-            categories << cats.at(catIndex).name;
+        if (m_categoryNames.isEmpty()) {
+            const auto cats = m_engine->categoriesMetadata();
+            for (const auto &cat : cats) {
+                m_categoryNames.insert(cat.id, cat.name);
+            }
+        }
+        const auto catIt = m_categoryNames.constFind(entry.category());
+        if (catIt != m_categoryNames.constEnd()) {
+            categories << *catIt;
         }
         if (m_hasApplications) {
             categories << QLatin1String("Application");
@@ -328,6 +342,11 @@ void KNSBackend::receivedEntries(const KNSCore::EntryInternal::List& entries)
         return resourceForEntry(entry);
     });
 
+    if (m_searchRequestPending && !m_onePage) {
+        m_searchRequestPending = false;
+        m_searchCache.insert(m_searchRequest, new CachedPage{resources, QDateTime::currentDateTimeUtc()});
+    }
+
     if (!resources.isEmpty()) {
         Q_EMIT receivedResources(resources);
     } else {
@@ -352,6 +371,9 @@ void KNSBackend::fetchMore()
     // data request will conclude immediately, causing m_responsePending to remain true
     // for perpetuity as the slots will be called before the function returns.
     m_responsePending = true;
+    ++m_currentSearchPage;
+    m_searchRequest = { m_currentSearchTerm, m_currentSearchPage };
+    m_searchRequestPending = true;
     m_engine->requestMoreData();
 }
 
@@ -426,6 +448,7 @@ void KNSBackend::signalErrorCode(const KNSCore::ErrorCode& errorCode, const QStr
         break;
     }
     m_responsePending = false;
+    m_searchRequestPending = false;
     Q_EMIT searchFinished();
     Q_EMIT availableForQueries();
     // Setting setFetching to false when we get an error ensures we don't end up in an eternally-fetching state
@@ -570,8 +593,35 @@ ResultsStream* KNSBackend::search(const AbstractResourcesBackend::Filters& filte
     return voidStream();
 }
 
+bool KNSBackend::searchFromCache(ResultsStream* stream, const QString &searchText)
+{
+    // Only a search that was paged through to its end can be answered from the cache,
+    // there's no fetching more from the engine where a partial one left off
+    QVector<AbstractResource*> resources;
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (int page = 0; ; ++page) {
+        const CachedPage* cached = m_searchCache.object({searchText, page});
+        if (!cached || cached->fetched.secsTo(now) > s_searchCacheTtl)
+            return false;
+        if (cached->resources.isEmpty())
+            break;
+        resources += cached->resources;
+    }
+
+    QTimer::singleShot(0, stream, [stream, resources] {
+        if (!resources.isEmpty())
+            Q_EMIT stream->resourcesFound(resources);
+        stream->finish();
+    });
+    return true;
+}
+
 void KNSBackend::searchStream(ResultsStream* stream, const QString &searchText)
 {
+    // Repeated searches don't need to go through the engine, nor wait for it to be available
+    if (m_isValid && !isFetching() && searchFromCache(stream, searchText))
+        return;
+
     Q_EMIT startingSearch();
 
     auto start = [this, stream, searchText]() {
@@ -580,10 +630,15 @@ void KNSBackend::searchStream(ResultsStream* stream, const QString &searchText)
             stream->finish();
             return;
         }
+        // The engine may answer from its own cache right away
+        m_searchRequest = { searchText, 0 };
+        m_searchRequestPending = true;
         // No need to explicitly launch a search, setting the search term already does that for us
         m_engine->setSearchTerm(searchText);
         m_onePage = false;
         m_responsePending = true;
+        m_currentSearchTerm = searchText;
+        m_currentSearchPage = 0;
 
         connect(stream, &ResultsStream::fetchMore, this, &KNSBackend::fetchMore);
         connect(this, &KNSBackend::receivedResources, stream, &ResultsStream::resourcesFound);
@@ -616,6 +671,7 @@ ResultsStream * KNSBackend::findResourceByPackageName(const QUrl& search)
     auto stream = new ResultsStream(QLatin1String("KNS-byname-")+entryid);
     auto start = [this, entryid, stream, providerid]() {
         m_responsePending = true;
+        m_searchRequestPending = false;
         m_engine->fetchEntryById(entryid);
         m_onePage = false;
 
@@ -14,6 +14,9 @@
 #include "Transaction/AddonList.h"
 #include "discovercommon_export.h"
 
+#include <QCache>
+#include <QDateTime>
+
 class KNSReviews;
 class KNSResource;
 class StandardBackendUpdater;
@@ -83,6 +86,7 @@ private:
     void setFetching(bool f);
     void markInvalid(const QString &message);
     void searchStream(ResultsStream* stream, const QString &searchText);
+    bool searchFromCache(ResultsStream* stream, const QString &searchText);
     void fetchMore();
 
     bool m_onePage = false;
@@ -91,6 +95,22 @@ private:
     bool m_isValid;
     KNSCore::Engine* m_engine;
     QHash<QString, AbstractResource*> m_resourcesByName;
+    // Category id -> name, from the provider's categories metadata
+    QHash<QString, QString> m_categoryNames;
+
+    // Pages of the searches we have run against this provider, by search term and page.
+    // An empty page marks the end of the results.
+    struct CachedPage {
+        QVector<AbstractResource*> resources;
+        QDateTime fetched;
+    };
+    typedef QPair<QString, int> SearchPage;
+    QCache<SearchPage, CachedPage> m_searchCache;
+    QString m_currentSearchTerm;
+    int m_currentSearchPage = 0;
+    // The search page the engine was asked for, only the entries answering it are cached
+    SearchPage m_searchRequest;
+    bool m_searchRequestPending = false;
     KNSReviews* const m_reviews;
     QString m_name;
     QString m_iconName;
@@ -176,7 +176,7 @@ QStringList AppPackageKitResource::allPackageNames() const
 {
     auto ret = m_appdata.packageNames();
     if (ret.isEmpty()) {
-        ret = QStringList{ PackageKit::Daemon::packageName(availablePackageId()) };
+        ret = QStringList{ backend()->packageIds().name(availablePackageHandle()) };
     }
     return ret;
 }
@@ -48,12 +48,12 @@ static QSet<QString> involvedPackages(const QSet<AbstractResource*>& packages)
     foreach (AbstractResource * res, packages) {
 
         PackageKitResource * app = qobject_cast<PackageKitResource*>(res);
-        const QString pkgid = app->backend()->upgradeablePackageId(app);
-        if (pkgid.isEmpty()) {
+        const QStringList pkgids = app->backend()->upgradeablePackageIds(app);
+        if (pkgids.isEmpty()) {
             qWarning() << "no upgradeablePackageId for" << app;
             continue;
         }
-        packageIds.insert(pkgid);
+        packageIds.unite(kToSet(pkgids));
     }
     return packageIds;
 }
@@ -106,9 +106,12 @@ void PKTransaction::trigger(PackageKit::Transaction::TransactionFlags flags)
             opreationTag = 1;
             break;
         case Transaction::UpdateRole: {
-            const QStringList ids = packageIds(m_apps, [](PackageKitResource* r) {
-                return r->backend()->upgradeablePackageId(r);
-            });
+            QStringList ids;
+            for (auto app : qAsConst(m_apps)) {
+                auto r = qobject_cast<PackageKitResource*>(app);
+                ids += r->backend()->upgradeablePackageIds(r);
+            }
+            ids.removeDuplicates();
             if (ids.isEmpty()) {
                 //FIXME this state shouldn't exist
                 qWarning() << "UpdateRole no packages found!";
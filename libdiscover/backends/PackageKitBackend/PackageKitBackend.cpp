@@ -38,6 +38,7 @@
 #include "config-paths.h"
 #include "libdiscover_backend_debug.h"
 #include <network/HttpClient.h>
+#include <RefreshScheduler.h>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -71,9 +72,12 @@ PackageKitBackend::PackageKitBackend(QObject* parent)
     , m_refresher(nullptr)
     , m_isFetching(0)
     , m_reviews(AppStreamIntegration::global()->reviews())
+    , m_refreshScheduler(new RefreshScheduler(QStringLiteral("PackageKit"), std::chrono::hours(1), this))
 {
+    connect(m_refreshScheduler, &RefreshScheduler::refreshed, this, &PackageKitBackend::fetchUpdates);
+
     QTimer* t = new QTimer(this);
-    connect(t, &QTimer::timeout, this, &PackageKitBackend::checkForUpdates);
+    connect(t, &QTimer::timeout, this, &PackageKitBackend::refreshIfDue);
     t->setInterval(60 * 60 * 1000);
     t->setSingleShot(false);
     t->start();
@@ -104,7 +108,7 @@ PackageKitBackend::PackageKitBackend(QObject* parent)
     acquireFetching(true);
     setWhenAvailable(PackageKit::Daemon::getTimeSinceAction(PackageKit::Transaction::RoleRefreshCache), [this](uint timeSince) {
         if (timeSince > 3600)
-            checkForUpdates();
+            refreshIfDue();
         else
             fetchUpdates();
         acquireFetching(false);
@@ -238,7 +242,7 @@ void PackageKitBackend::searchPackagekitResources()
 
     connect(searchT, &PackageKit::Transaction::finished, this, [this](PackageKit::Transaction::Exit status) {
         getPackagesFinished();
-        checkForUpdates();
+        refreshIfDue();
     }, Qt::QueuedConnection);
 }
 
@@ -334,6 +338,7 @@ void PackageKitBackend::fetchUpdates()
     connect(m_getUpdatesTransaction, &PackageKit::Transaction::errorCode, this, &PackageKitBackend::transactionError);
     connect(m_getUpdatesTransaction, &PackageKit::Transaction::percentageChanged, this, &PackageKitBackend::fetchingUpdatesProgressChanged);
     m_updatesPackageId.clear();
+    m_updatesByName.clear();
     m_hasSecurityUpdates = false;
 
     m_updater->setProgressing(true);
@@ -359,22 +364,25 @@ void PackageKitBackend::addPackageNotArch(PackageKit::Transaction::Info info, co
 
 void PackageKitBackend::addPackage(PackageKit::Transaction::Info info, const QString &packageId, const QString &summary, bool arch)
 {
-    QString packageArch = PackageKit::Daemon::packageArch(packageId);
+    const auto sections = packageId.splitRef(QLatin1Char(';'));
+    const QStringRef packageArch = sections.value(2);
     if (packageArch == QLatin1String("source")) {
         // We do not add source packages, they make little sense here. If source is needed,
         // we are going to have to consider that in some other way, some other time
         // If we do not ignore them here, e.g. openSuse entirely fails at installing applications
         return;
     }
-    QString localArc = QSysInfo::currentCpuArchitecture();
-    if (localArc == "x86") {
-        localArc = "amd64";
-    }
-    if (packageArch != localArc && packageArch != "all") {
+    static const QString localArc = [] {
+        const QString arch = QSysInfo::currentCpuArchitecture();
+        return arch == QLatin1String("x86") ? QStringLiteral("amd64") : arch;
+    }();
+    if (packageArch != localArc && packageArch != QLatin1String("all")) {
         return;
     }
 
-    const QString packageName = PackageKit::Daemon::packageName(packageId);
+    // Only what we keep gets interned
+    const auto handle = m_packageIds.intern(packageId);
+    const QString packageName = m_packageIds.name(handle);
     QSet<AbstractResource*> r = resourcesByPackageName(packageName);
 
     if (r.isEmpty()) {
@@ -383,12 +391,13 @@ void PackageKitBackend::addPackage(PackageKit::Transaction::Info info, const QSt
         m_packagesToAdd.insert(pk);
     }
     foreach (auto res, r)
-        static_cast<PackageKitResource*>(res)->addPackageId(info, packageId, arch);
+        static_cast<PackageKitResource*>(res)->addPackageHandle(info, handle, arch);
 }
 
 void PackageKitBackend::getPackagesFinished()
 {
     includePackagesToAdd();
+    compactPackageIds();
     if (m_packageKitId.size() > 0) {
         fetchDetails(m_packageKitId);
     }
@@ -468,15 +477,18 @@ void PackageKitBackend::checkForUpdates()
 {
     if (PackageKit::Daemon::global()->offline()->updateTriggered()) {
         qCDebug(LIBDISCOVER_BACKEND_LOG) << "Won't be checking for updates again, the system needs a reboot to apply the fetched offline updates.";
+        m_refreshScheduler->finish(false);
         return;
     }
 
     if (!m_refresher) {
         acquireFetching(true);
+        m_refreshScheduler->start();
         m_refresher = PackageKit::Daemon::refreshCache(false);
 
         connect(m_refresher.data(), &PackageKit::Transaction::errorCode, this, &PackageKitBackend::transactionError);
-        connect(m_refresher.data(), &PackageKit::Transaction::finished, this, [this]() {
+        connect(m_refresher.data(), &PackageKit::Transaction::finished, this, [this](PackageKit::Transaction::Exit exit) {
+            m_refreshScheduler->finish(exit == PackageKit::Transaction::ExitSuccess);
             m_refresher = nullptr;
             fetchUpdates();
             acquireFetching(false);
@@ -486,6 +498,15 @@ void PackageKitBackend::checkForUpdates()
     }
 }
 
+void PackageKitBackend::refreshIfDue()
+{
+    // The notifier or another Discover window may have refreshed recently
+    if (m_refreshScheduler->startIfDue())
+        checkForUpdates();
+    else
+        fetchUpdates();
+}
+
 QList<AppStream::Component> PackageKitBackend::componentsById(const QString& id) const
 {
     Q_ASSERT(m_appstreamInitialized);
@@ -822,11 +843,10 @@ QSet<AbstractResource*> PackageKitBackend::upgradeablePackages() const
 
     QSet<AbstractResource*> ret;
     ret.reserve(m_updatesPackageId.size());
-    Q_FOREACH (const QString& pkgid, m_updatesPackageId) {
-        const QString pkgname = PackageKit::Daemon::packageName(pkgid);
-        const auto pkgs = resourcesByPackageName(pkgname);
+    for (auto handle : m_updatesPackageId) {
+        const auto pkgs = resourcesByPackageName(m_packageIds.name(handle));
         if (pkgs.isEmpty()) {
-            qWarning() << "couldn't find resource for" << pkgid;
+            qWarning() << "couldn't find resource for" << m_packageIds.packageId(handle);
         }
         ret.unite(pkgs);
     }
@@ -854,22 +874,27 @@ void PackageKitBackend::addPackageToUpdate(PackageKit::Transaction::Info info, c
     if(packageId.contains("qterm")){
         qDebug()<<Q_FUNC_INFO<<" qterm:::" << packageId;
     }
-    m_updatesPackageId += packageId;
+    const auto handle = m_packageIds.intern(packageId);
+    m_updatesPackageId += handle;
+    m_updatesByName[m_packageIds.nameAtom(handle)] += handle;
     addPackage(info, packageId, summary, true);
 }
 
 void PackageKitBackend::getUpdatesFinished(PackageKit::Transaction::Exit, uint)
 {
     if (!m_updatesPackageId.isEmpty()) {
-        resolvePackages(kTransform<QStringList>(m_updatesPackageId, [](const QString &pkgid) {
-            return PackageKit::Daemon::packageName(pkgid);
+        resolvePackages(kTransform<QStringList>(m_updatesPackageId, [this](PackageKitIdTable::Handle handle) {
+            return m_packageIds.name(handle);
+        }));
+        fetchDetails(kTransform<QSet<QString>>(m_updatesPackageId, [this](PackageKitIdTable::Handle handle) {
+            return m_packageIds.packageId(handle);
         }));
-        fetchDetails(m_updatesPackageId);
     }
 
     m_updater->setProgressing(false);
 
     includePackagesToAdd();
+    compactPackageIds();
     if (isFetching()) {
         auto a = new OneTimeAction([this] {
             emit updatesCountChanged();
@@ -881,17 +906,63 @@ void PackageKitBackend::getUpdatesFinished(PackageKit::Transaction::Exit, uint)
 
 bool PackageKitBackend::isPackageNameUpgradeable(const PackageKitResource* res) const
 {
-    return !upgradeablePackageId(res).isEmpty();
+    return upgradeablePackageHandle(res) != PackageKitIdTable::InvalidHandle;
 }
 
 QString PackageKitBackend::upgradeablePackageId(const PackageKitResource* res) const
 {
-    QString name = res->packageName();
-    foreach (const QString& pkgid, m_updatesPackageId) {
-        if (PackageKit::Daemon::packageName(pkgid) == name)
-            return pkgid;
+    return m_packageIds.packageId(upgradeablePackageHandle(res));
+}
+
+QStringList PackageKitBackend::upgradeablePackageIds(const PackageKitResource* res) const
+{
+    const auto handles = m_updatesByName.value(m_packageIds.nameAtom(res->packageName()));
+    return kTransform<QStringList>(handles, [this](PackageKitIdTable::Handle handle) {
+        return m_packageIds.packageId(handle);
+    });
+}
+
+PackageKitIdTable::Handle PackageKitBackend::upgradeablePackageHandle(const PackageKitResource* res) const
+{
+    const int nameAtom = m_packageIds.nameAtom(res->packageName());
+    if (nameAtom == PackageKitIdTable::InvalidHandle)
+        return PackageKitIdTable::InvalidHandle;
+
+    // With several architectures installed, show the one matching the installed package
+    const auto handles = m_updatesByName.value(nameAtom);
+    if (handles.isEmpty())
+        return PackageKitIdTable::InvalidHandle;
+    const int installedArch = m_packageIds.archAtom(res->installedPackageHandle());
+    for (auto handle : handles) {
+        if (m_packageIds.archAtom(handle) == installedArch)
+            return handle;
     }
-    return QString();
+    return handles.constFirst();
+}
+
+void PackageKitBackend::compactPackageIds()
+{
+    // Ids from previous refreshes are only kept as long as something refers to them,
+    // that's every resource alive and not only the listed ones, local files have theirs too
+    QSet<PackageKitIdTable::Handle> live = m_updatesPackageId;
+    for (auto res : qAsConst(m_resources))
+        live.unite(res->packageHandles());
+
+    if (live.size() == m_packageIds.size())
+        return;
+
+    const auto moved = m_packageIds.compact(live);
+    const auto remap = [&moved](PackageKitIdTable::Handle handle) {
+        return moved.value(handle, PackageKitIdTable::InvalidHandle);
+    };
+    for (auto res : qAsConst(m_resources))
+        res->remapPackageHandles(moved);
+
+    // The name atoms were renumbered as well
+    m_updatesPackageId = kTransform<QSet<PackageKitIdTable::Handle>>(m_updatesPackageId, remap);
+    m_updatesByName.clear();
+    for (auto handle : qAsConst(m_updatesPackageId))
+        m_updatesByName[m_packageIds.nameAtom(handle)] += handle;
 }
 
 void PackageKitBackend::fetchDetails(const QSet<QString>& pkgid)
@@ -28,6 +28,7 @@ class PackageKitUpdater;
 class OdrsReviewsBackend;
 class PKResultsStream;
 class PKResolveTransaction;
+class RefreshScheduler;
 
 class DISCOVERCOMMON_EXPORT PackageKitBackend : public AbstractResourcesBackend
 {
@@ -56,6 +57,12 @@ public:
 
     bool isPackageNameUpgradeable(const PackageKitResource* res) const;
     QString upgradeablePackageId(const PackageKitResource* res) const;
+    /// @returns every upgradeable package id with the name of @p res, one for each architecture
+    QStringList upgradeablePackageIds(const PackageKitResource* res) const;
+    PackageKitIdTable::Handle upgradeablePackageHandle(const PackageKitResource* res) const;
+    const PackageKitIdTable& packageIds() const {
+        return m_packageIds;
+    }
     QVector<AppPackageKitResource*> extendedBy(const QString& id) const;
 
     void resolvePackages(const QStringList &packageNames);
@@ -117,16 +124,22 @@ private:
     void showResource();
     AppPackageKitResource* addComponent(const AppStream::Component& component, const QStringList& pkgNames);
     void updateProxy();
+    void refreshIfDue();
+    void compactPackageIds();
 
     QScopedPointer<AppStream::Pool> m_appdata;
     PackageKitUpdater* m_updater;
     QPointer<PackageKit::Transaction> m_refresher;
     int m_isFetching;
-    QSet<QString> m_updatesPackageId;
+    PackageKitIdTable m_packageIds;
+    QSet<PackageKitIdTable::Handle> m_updatesPackageId;
+    QHash<int, QVector<PackageKitIdTable::Handle>> m_updatesByName;
     QSet<QString> m_packageKitId;
     bool m_hasSecurityUpdates = false;
     QSet<PackageKitResource*> m_packagesToAdd;
     QSet<PackageKitResource*> m_packagesToDelete;
+    // Every resource alive, whether it's listed or not, they all hold package id handles
+    QSet<PackageKitResource*> m_resources;
     bool m_appstreamInitialized = true;//false;
 
     struct {
@@ -139,6 +152,7 @@ private:
     QTimer m_delayedDetailsFetch;
     QSet<QString> m_packageNamesToFetchDetails;
     QSharedPointer<OdrsReviewsBackend> m_reviews;
+    RefreshScheduler* const m_refreshScheduler;
     QPointer<PackageKit::Transaction> m_getUpdatesTransaction;
     QThreadPool m_threadPool;
     QPointer<PKResolveTransaction> m_resolveTransaction;
@@ -0,0 +1,90 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "PackageKitIdTable.h"
+
+constexpr PackageKitIdTable::Handle PackageKitIdTable::InvalidHandle;
+
+// Same layout PackageKit::Daemon::packageName() & co. expect, missing sections are left empty
+static QStringRef section(const QVector<QStringRef> &sections, int i)
+{
+    return i < sections.size() ? sections.at(i) : QStringRef();
+}
+
+PackageKitIdTable::Handle PackageKitIdTable::intern(const QString &packageId)
+{
+    if (packageId.isEmpty())
+        return InvalidHandle;
+
+    const auto sections = packageId.splitRef(QLatin1Char(';'));
+    const Entry entry = { internAtom(section(sections, 0)), internAtom(section(sections, 1)), internAtom(section(sections, 2)), internAtom(section(sections, 3)) };
+    auto it = m_handles.constFind(entry);
+    if (it != m_handles.constEnd())
+        return *it;
+
+    const Handle h = m_entries.size();
+    m_entries.append(entry);
+    m_handles.insert(entry, h);
+    return h;
+}
+
+PackageKitIdTable::Handle PackageKitIdTable::find(const QString &packageId) const
+{
+    const auto sections = packageId.splitRef(QLatin1Char(';'));
+    const Entry entry = { findAtom(section(sections, 0)), findAtom(section(sections, 1)), findAtom(section(sections, 2)), findAtom(section(sections, 3)) };
+    if (entry.name == InvalidHandle || entry.version == InvalidHandle || entry.arch == InvalidHandle || entry.data == InvalidHandle)
+        return InvalidHandle;
+    return m_handles.value(entry, InvalidHandle);
+}
+
+QString PackageKitIdTable::packageId(Handle h) const
+{
+    if (!isValid(h))
+        return {};
+
+    const Entry &entry = m_entries[h];
+    return m_atoms[entry.name] + QLatin1Char(';') + m_atoms[entry.version] + QLatin1Char(';') + m_atoms[entry.arch] + QLatin1Char(';') + m_atoms[entry.data];
+}
+
+int PackageKitIdTable::internAtom(const QStringRef &value)
+{
+    const QString str = value.toString();
+    auto it = m_atomIndex.constFind(str);
+    if (it != m_atomIndex.constEnd())
+        return *it;
+
+    const int idx = m_atoms.size();
+    m_atoms.append(str);
+    m_atomIndex.insert(str, idx);
+    return idx;
+}
+
+int PackageKitIdTable::findAtom(const QStringRef &value) const
+{
+    return m_atomIndex.value(value.toString(), InvalidHandle);
+}
+
+QHash<PackageKitIdTable::Handle, PackageKitIdTable::Handle> PackageKitIdTable::compact(const QSet<Handle> &live)
+{
+    PackageKitIdTable table;
+    QHash<Handle, Handle> ret;
+    ret.reserve(live.size());
+    for (Handle h : live) {
+        if (!isValid(h))
+            continue;
+
+        const Entry &entry = m_entries[h];
+        const Entry moved = { table.internAtom(QStringRef(&m_atoms[entry.name])), table.internAtom(QStringRef(&m_atoms[entry.version])),
+                              table.internAtom(QStringRef(&m_atoms[entry.arch])), table.internAtom(QStringRef(&m_atoms[entry.data])) };
+        const Handle newHandle = table.m_entries.size();
+        table.m_entries.append(moved);
+        table.m_handles.insert(moved, newHandle);
+        ret.insert(h, newHandle);
+    }
+
+    *this = std::move(table);
+    return ret;
+}
@@ -0,0 +1,116 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef PACKAGEKITIDTABLE_H
+#define PACKAGEKITIDTABLE_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+/**
+ * Parses PackageKit package ids ("name;version;arch;data") once and keeps
+ * their sections interned, so that resources can refer to a package id by an
+ * integer handle instead of carrying and re-splitting the full string.
+ *
+ * Only the sections are stored, the full id is put back together when asked
+ * for. Handles are stable until compact() is called, which drops everything
+ * that is not in use anymore. It's only meant to be used from the thread that
+ * owns the backend.
+ */
+class PackageKitIdTable
+{
+public:
+    typedef int Handle;
+    static constexpr Handle InvalidHandle = -1;
+
+    /** @returns the handle for @p packageId, adding it to the table if necessary */
+    Handle intern(const QString &packageId);
+
+    /** @returns the handle for @p packageId or InvalidHandle if it was never interned */
+    Handle find(const QString &packageId) const;
+
+    QString packageId(Handle h) const;
+    QString name(Handle h) const
+    {
+        return atom(h, &Entry::name);
+    }
+    QString version(Handle h) const
+    {
+        return atom(h, &Entry::version);
+    }
+    QString arch(Handle h) const
+    {
+        return atom(h, &Entry::arch);
+    }
+    int archAtom(Handle h) const
+    {
+        return isValid(h) ? m_entries[h].arch : InvalidHandle;
+    }
+    QString data(Handle h) const
+    {
+        return atom(h, &Entry::data);
+    }
+
+    /** @returns an id that is equal for all handles sharing the same package name */
+    int nameAtom(Handle h) const
+    {
+        return isValid(h) ? m_entries[h].name : InvalidHandle;
+    }
+    int nameAtom(const QString &name) const
+    {
+        return m_atomIndex.value(name, InvalidHandle);
+    }
+
+    bool isValid(Handle h) const
+    {
+        return h >= 0 && h < m_entries.size();
+    }
+
+    int size() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * Drops every entry but the @p live ones, along with the sections only they used.
+     * @returns the new handle for every one of the @p live handles
+     */
+    QHash<Handle, Handle> compact(const QSet<Handle> &live);
+
+private:
+    struct Entry {
+        int name;
+        int version;
+        int arch;
+        int data;
+
+        bool operator==(const Entry &other) const
+        {
+            return name == other.name && version == other.version && arch == other.arch && data == other.data;
+        }
+    };
+    friend uint qHash(const Entry &entry, uint seed)
+    {
+        return qHash(qMakePair(qMakePair(entry.name, entry.version), qMakePair(entry.arch, entry.data)), seed);
+    }
+
+    int internAtom(const QStringRef &value);
+    int findAtom(const QStringRef &value) const;
+    QString atom(Handle h, int Entry::*section) const
+    {
+        return isValid(h) ? m_atoms[m_entries[h].*section] : QString();
+    }
+
+    QVector<Entry> m_entries;
+    QHash<Entry, Handle> m_handles;
+    QVector<QString> m_atoms;
+    QHash<QString, int> m_atomIndex;
+};
+
+#endif // PACKAGEKITIDTABLE_H
@@ -6,6 +6,7 @@
  */
 
 #include "PackageKitNotifier.h"
+#include <RefreshScheduler.h>
 
 #include <QTimer>
 #include <QStandardPaths>
@@ -30,7 +31,9 @@ PackageKitNotifier::PackageKitNotifier(QObject* parent)
     : BackendNotifierModule(parent)
     , m_securityUpdates(0)
     , m_normalUpdates(0)
+    , m_refreshScheduler(new RefreshScheduler(QStringLiteral("PackageKit"), std::chrono::hours(24), this))
 {
+    connect(m_refreshScheduler, &RefreshScheduler::refreshed, this, &PackageKitNotifier::recheckSystemUpdateNeeded);
     connect(PackageKit::Daemon::global(), &PackageKit::Daemon::updatesChanged, this, &PackageKitNotifier::recheckSystemUpdateNeeded);
     connect(PackageKit::Daemon::global(), &PackageKit::Daemon::transactionListChanged, this, &PackageKitNotifier::transactionListChanged);
     connect(PackageKit::Daemon::global(), &PackageKit::Daemon::restartScheduled, this, &PackageKitNotifier::nowNeedsReboot);
@@ -164,17 +167,18 @@ void PackageKitNotifier::setupGetUpdatesTransaction(PackageKit::Transaction* tra
 
     trans->setProperty("normalUpdates", 0);
     trans->setProperty("securityUpdates", 0);
+    trans->setProperty("packageIds", QStringList());
     connect(trans, &PackageKit::Transaction::package, this, &PackageKitNotifier::package);
     connect(trans, &PackageKit::Transaction::finished, this, &PackageKitNotifier::finished);
 }
 
-void PackageKitNotifier::package(PackageKit::Transaction::Info info, const QString &/*packageID*/, const QString &/*summary*/)
+void PackageKitNotifier::package(PackageKit::Transaction::Info info, const QString &packageID, const QString &/*summary*/)
 {
     PackageKit::Transaction * trans = qobject_cast<PackageKit::Transaction *>(sender());
 
     switch (info) {
     case PackageKit::Transaction::InfoBlocked:
-        break; //skip, we ignore blocked updates
+        return; //skip, we ignore blocked updates
     case PackageKit::Transaction::InfoSecurity:
         trans->setProperty("securityUpdates", trans->property("securityUpdates").toInt()+1);
         break;
@@ -182,6 +186,7 @@ void PackageKitNotifier::package(PackageKit::Transaction::Info info, const QStri
         trans->setProperty("normalUpdates", trans->property("normalUpdates").toInt()+1);
         break;
     }
+    trans->setProperty("packageIds", trans->property("packageIds").toStringList() << packageID);
 }
 
 void PackageKitNotifier::finished(PackageKit::Transaction::Exit /*exit*/, uint)
@@ -194,12 +199,31 @@ void PackageKitNotifier::finished(PackageKit::Transaction::Exit /*exit*/, uint)
 
     m_normalUpdates = normalUpdates;
     m_securityUpdates = securityUpdates;
+    m_updatePackageIds = trans->property("packageIds").toStringList();
+    m_updatePackageIds.sort();
 
     if (changed) {
         Q_EMIT foundUpdates();
     }
 }
 
+void PackageKitNotifier::prefetchUpdates()
+{
+    if (m_prefetcher || m_updatePackageIds.isEmpty() || m_updatePackageIds == m_prefetchedPackageIds
+        || PackageKit::Daemon::global()->offline()->updateTriggered())
+        return;
+
+    const QStringList packageIds = m_updatePackageIds;
+    m_prefetcher = PackageKit::Daemon::updatePackages(packageIds, PackageKit::Transaction::TransactionFlagOnlyTrusted | PackageKit::Transaction::TransactionFlagOnlyDownload);
+    connect(m_prefetcher.data(), &PackageKit::Transaction::finished, this, [this, packageIds] (PackageKit::Transaction::Exit exit) {
+        if (exit == PackageKit::Transaction::ExitSuccess) {
+            m_prefetchedPackageIds = packageIds;
+        } else {
+            qCDebug(LIBDISCOVER_BACKEND_LOG) << "could not download the updates ahead of time" << exit;
+        }
+    });
+}
+
 bool PackageKitNotifier::hasUpdates()
 {
     return m_normalUpdates > 0;
@@ -222,9 +246,13 @@ void PackageKitNotifier::onDistroUpgrade(PackageKit::Transaction::DistroUpgrade
 
 void PackageKitNotifier::refreshDatabase()
 {
-    if (!m_refresher) {
+    // Discover may have refreshed already
+    if (!m_refresher && m_refreshScheduler->startIfDue()) {
         m_refresher = PackageKit::Daemon::refreshCache(false);
-        connect(m_refresher.data(), &PackageKit::Transaction::finished, this, &PackageKitNotifier::recheckSystemUpdateNeeded);
+        connect(m_refresher.data(), &PackageKit::Transaction::finished, this, [this] (PackageKit::Transaction::Exit exit) {
+            m_refreshScheduler->finish(exit == PackageKit::Transaction::ExitSuccess);
+            recheckSystemUpdateNeeded();
+        });
     }
 
     if (!m_distUpgrades && (PackageKit::Daemon::roles() & PackageKit::Transaction::RoleUpgradeSystem)) {
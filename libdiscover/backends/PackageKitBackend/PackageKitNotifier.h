@@ -14,6 +14,7 @@
 
 class QTimer;
 class QProcess;
+class RefreshScheduler;
 
 class PackageKitNotifier : public BackendNotifierModule
 {
@@ -28,6 +29,7 @@ public:
     bool hasSecurityUpdates() override;
     void recheckSystemUpdateNeeded() override;
     void refreshDatabase();
+    void prefetchUpdates() override;
     bool needsReboot() const override {
         return m_needsReboot;
     }
@@ -51,7 +53,11 @@ private:
     uint m_normalUpdates;
     QPointer<PackageKit::Transaction> m_refresher;
     QPointer<PackageKit::Transaction> m_distUpgrades;
+    QPointer<PackageKit::Transaction> m_prefetcher;
+    QStringList m_updatePackageIds;
+    QStringList m_prefetchedPackageIds;
     QTimer* m_recheckTimer;
+    RefreshScheduler* const m_refreshScheduler;
 
     QHash<QString, PackageKit::Transaction*> m_transactions;
 };
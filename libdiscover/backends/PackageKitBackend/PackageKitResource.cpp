@@ -33,6 +33,7 @@ PackageKitResource::PackageKitResource(QString packageName, QString summary, Pac
     , m_packageName(std::move(packageName))
 {
     setObjectName(m_packageName);
+    parent->m_resources.insert(this);
 
     connect(this, &PackageKitResource::dependenciesFound, this, [this](const QJsonObject& obj) {
         setDependenciesCount(obj.size());
@@ -40,6 +41,13 @@ PackageKitResource::PackageKitResource(QString packageName, QString summary, Pac
     connect(this, &PackageKitResource::openAppStatusChanged, this, &PackageKitResource::onOpenAppSlots);
 }
 
+PackageKitResource::~PackageKitResource()
+{
+    // The backend is gone already when it's the one destroying its children
+    if (auto b = backend())
+        b->m_resources.remove(this);
+}
+
 QString PackageKitResource::name() const
 {
     if (m_name == "") {
@@ -59,22 +67,66 @@ QStringList PackageKitResource::allPackageNames() const
 }
 
 QString PackageKitResource::availablePackageId() const
+{
+    return backend()->packageIds().packageId(availablePackageHandle());
+}
+
+QString PackageKitResource::installedPackageId() const
+{
+    return backend()->packageIds().packageId(installedPackageHandle());
+}
+
+PackageKitIdTable::Handle PackageKitResource::availablePackageHandle() const
 {
     //First we check if it's upgradeable and use this version to display
-    const QString pkgid = backend()->upgradeablePackageId(this);
-    if (!pkgid.isEmpty())
-        return pkgid;
+    const auto handle = backend()->upgradeablePackageHandle(this);
+    if (handle != PackageKitIdTable::InvalidHandle)
+        return handle;
 
-    QMap<PackageKit::Transaction::Info, QStringList>::const_iterator it = m_packages.constFind(PackageKit::Transaction::InfoAvailable);
-    if (it != m_packages.constEnd())
+    auto it = m_packages.constFind(PackageKit::Transaction::InfoAvailable);
+    if (it != m_packages.constEnd() && !it->isEmpty())
         return it->last();
-    return installedPackageId();
+    return installedPackageHandle();
 }
 
-QString PackageKitResource::installedPackageId() const
+PackageKitIdTable::Handle PackageKitResource::installedPackageHandle() const
+{
+    auto it = m_packages.constFind(PackageKit::Transaction::InfoInstalled);
+    return it == m_packages.constEnd() || it->isEmpty() ? PackageKitIdTable::InvalidHandle : it->last();
+}
+
+QSet<PackageKitIdTable::Handle> PackageKitResource::packageHandles() const
+{
+    QSet<PackageKitIdTable::Handle> ret;
+    for (const auto &handles : m_packages)
+        ret.unite(kToSet(handles));
+    return ret;
+}
+
+void PackageKitResource::remapPackageHandles(const QHash<PackageKitIdTable::Handle, PackageKitIdTable::Handle> &moved)
+{
+    for (auto it = m_packages.begin(), end = m_packages.end(); it != end; ++it) {
+        QVector<PackageKitIdTable::Handle> handles;
+        handles.reserve(it->size());
+        for (auto handle : qAsConst(*it)) {
+            const auto newHandle = moved.value(handle, PackageKitIdTable::InvalidHandle);
+            if (newHandle != PackageKitIdTable::InvalidHandle)
+                handles += newHandle;
+        }
+        *it = handles;
+    }
+}
+
+QMap<PackageKit::Transaction::Info, QStringList> PackageKitResource::packages() const
 {
-    const auto installed = m_packages[PackageKit::Transaction::InfoInstalled];
-    return installed.isEmpty() ? QString() : installed.last();
+    const auto &ids = backend()->packageIds();
+    QMap<PackageKit::Transaction::Info, QStringList> ret;
+    for (auto it = m_packages.constBegin(), itEnd = m_packages.constEnd(); it != itEnd; ++it) {
+        ret[it.key()] = kTransform<QStringList>(*it, [&ids](PackageKitIdTable::Handle h) {
+            return ids.packageId(h);
+        });
+    }
+    return ret;
 }
 
 void PackageKitResource::invokeApplication() const
@@ -171,12 +223,12 @@ QList<PackageState> PackageKitResource::addonsInformation()
 
 QString PackageKitResource::availableVersion() const
 {
-    return PackageKit::Daemon::packageVersion(availablePackageId());
+    return backend()->packageIds().version(availablePackageHandle());
 }
 
 QString PackageKitResource::installedVersion() const
 {
-    return PackageKit::Daemon::packageVersion(installedPackageId());
+    return backend()->packageIds().version(installedPackageHandle());
 }
 
 int PackageKitResource::size()
@@ -187,8 +239,7 @@ int PackageKitResource::size()
 
 QString PackageKitResource::origin() const
 {
-    auto pkgid = availablePackageId();
-    return PackageKit::Daemon::packageData(pkgid);
+    return backend()->packageIds().data(availablePackageHandle());
 }
 
 QString PackageKitResource::section()
@@ -210,14 +261,25 @@ AbstractResource::State PackageKitResource::state()
 
 void PackageKitResource::addPackageId(PackageKit::Transaction::Info info, const QString &packageId, bool arch)
 {
+    addPackageHandle(info, backend()->m_packageIds.intern(packageId), arch);
+}
+
+void PackageKitResource::addPackageHandle(PackageKit::Transaction::Info info, PackageKitIdTable::Handle handle, bool arch)
+{
+    if (handle == PackageKitIdTable::InvalidHandle)
+        return;
+
     if (info == PackageKit::Transaction::InfoAvailable && m_packages.contains(PackageKit::Transaction::InfoInstalled)) {
         m_packages.remove(PackageKit::Transaction::InfoInstalled);
     }
     auto oldState = state();
+    auto &handles = m_packages[info];
+    if (handles.contains(handle))
+        return;
     if (arch)
-        m_packages[info].append(packageId);
+        handles.append(handle);
     else
-        m_packages[info].prepend(packageId);
+        handles.prepend(handle);
 
     if (oldState != state())
         emit stateChanged();
@@ -10,6 +10,7 @@
 #include <resources/AbstractResource.h>
 #include <PackageKit/Transaction>
 #include <PackageKit/Details>
+#include "PackageKitIdTable.h"
 
 class PackageKitBackend;
 
@@ -19,6 +20,7 @@ class PackageKitResource : public AbstractResource
     Q_PROPERTY(QStringList objects MEMBER m_objects CONSTANT)
 public:
     explicit PackageKitResource(QString  packageName, QString  summary, PackageKitBackend* parent);
+    ~PackageKitResource() override;
     QString packageName() const override;
     QString name() const override;
     QString comment() override;
@@ -45,14 +47,17 @@ public:
     virtual QStringList allPackageNames() const;
     QString installedPackageId() const;
     QString availablePackageId() const;
+    PackageKitIdTable::Handle installedPackageHandle() const;
+    PackageKitIdTable::Handle availablePackageHandle() const;
 
     void clearPackageIds() {
         m_packages.clear();
     }
+    QSet<PackageKitIdTable::Handle> packageHandles() const;
+    /// Called when the backend compacts its PackageKitIdTable, handles that aren't in @p moved are dropped
+    void remapPackageHandles(const QHash<PackageKitIdTable::Handle, PackageKitIdTable::Handle> &moved);
 
-    QMap<PackageKit::Transaction::Info, QStringList> packages() const {
-        return m_packages;
-    }
+    QMap<PackageKit::Transaction::Info, QStringList> packages() const;
 
     PackageKitBackend* backend() const;
 
@@ -84,6 +89,7 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     void addPackageId(PackageKit::Transaction::Info info, const QString &packageId, bool arch);
+    void addPackageHandle(PackageKit::Transaction::Info info, PackageKitIdTable::Handle handle, bool arch);
     void setDetails(const PackageKit::Details& details);
 
     void updateDetail(const QString &packageID,
@@ -111,7 +117,7 @@ private:
     /** fetches details individually, it's better if done in batch, like for updates */
     virtual void fetchDetails();
 
-    QMap<PackageKit::Transaction::Info, QStringList> m_packages;
+    QMap<PackageKit::Transaction::Info, QVector<PackageKitIdTable::Handle>> m_packages;
     const QString m_summary;
     const QString m_packageName;
     int m_dependenciesCount = -1;
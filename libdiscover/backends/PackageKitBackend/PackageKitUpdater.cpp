@@ -13,6 +13,9 @@
 #include <QSet>
 #include <network/networkutils.h>
 
+#include <KConfig>
+#include <KConfigGroup>
+#include <KIdleTime>
 #include <KLocalizedString>
 
 #include "libdiscover_backend_debug.h"
@@ -215,11 +218,20 @@ PackageKitUpdater::PackageKitUpdater(PackageKitBackend * parent)
     connect(TransactionModel::global(),&TransactionModel::lastTransactionFinished,[this]() {
         m_backend->fetchUpdates();
         fetchLastUpdateTime();
+        schedulePrefetch();
     });
+
+    // Downloads the updates once the user has been away for a while, so that
+    // updating only needs to install them
+    connect(KIdleTime::instance(), QOverload<int,int>::of(&KIdleTime::timeoutReached), this, &PackageKitUpdater::idleTimeoutReached);
+    connect(m_backend, &PackageKitBackend::updatesCountChanged, this, &PackageKitUpdater::schedulePrefetch);
+    connect(TransactionModel::global(), &TransactionModel::startingFirstTransaction, this, &PackageKitUpdater::cancelPrefetch);
 }
 
 PackageKitUpdater::~PackageKitUpdater()
 {
+    if (m_prefetchTimeout >= 0)
+        KIdleTime::instance()->removeIdleTimeout(m_prefetchTimeout);
 }
 
 void PackageKitUpdater::prepare()
@@ -303,13 +315,13 @@ QSet<QString> PackageKitUpdater::involvedPackages(const QSet<AbstractResource*>&
         }
 
         PackageKitResource * app = qobject_cast<PackageKitResource*>(res);
-        const QString pkgid = m_backend->upgradeablePackageId(app);
-        if (pkgid.isEmpty()) {
+        const QStringList pkgids = m_backend->upgradeablePackageIds(app);
+        if (pkgids.isEmpty()) {
             qWarning() << "no upgradeablePackageId for" << app;
             continue;
         }
 
-        packageIds.insert(pkgid);
+        packageIds.unite(kToSet(pkgids));
     }
     return packageIds;
 }
@@ -356,6 +368,8 @@ void PackageKitUpdater::start()
 {
     Q_ASSERT(!isProgressing());
 
+    // PackageKit would make us wait for it otherwise, what it downloaded is kept
+    cancelPrefetch();
     setupTransaction(PackageKit::Transaction::TransactionFlagSimulate);
     setProgressing(true);
 }
@@ -598,10 +612,15 @@ void PackageKitUpdater::repoSignatureRequired(const QString& packageID, const QS
 }
 
 double PackageKitUpdater::updateSize() const
+{
+    return packagesSize(m_toUpgrade);
+}
+
+double PackageKitUpdater::packagesSize(const QSet<AbstractResource*>& packages) const
 {
     double ret = 0.;
     QSet<QString> donePkgs;
-    for (AbstractResource * res : m_toUpgrade) {
+    for (AbstractResource * res : packages) {
         if (auto upgrade = dynamic_cast<SystemUpgrade*>(res)) {
             ret += upgrade->size();
             continue;
@@ -621,3 +640,99 @@ quint64 PackageKitUpdater::downloadSpeed() const
 {
     return m_transaction ? m_transaction->speed() : 0;
 }
+
+quint64 PackageKitUpdater::prefetchedSize() const
+{
+    return m_prefetchedSize;
+}
+
+void PackageKitUpdater::setPrefetchedSize(quint64 size)
+{
+    if (m_prefetchedSize != size) {
+        m_prefetchedSize = size;
+        Q_EMIT prefetchedSizeChanged();
+    }
+}
+
+bool PackageKitUpdater::canPrefetch() const
+{
+    // Shared with the notifier, which prefetches when Discover isn't running
+    KConfig config(QStringLiteral("PlasmaDiscoverUpdates"));
+    if (!KConfigGroup(&config, "Global").readEntry("PrefetchUpdates", false))
+        return false;
+
+    // PackageKit can't tell whether a wireless connection is metered (e.g. a tethered phone),
+    // so only wired ones are used
+    if (PackageKit::Daemon::global()->networkState() != PackageKit::Daemon::NetworkWired)
+        return false;
+
+    return !m_prefetcher && !isProgressing() && TransactionModel::global()->rowCount() == 0
+        && !PackageKit::Daemon::global()->offline()->updateTriggered();
+}
+
+void PackageKitUpdater::schedulePrefetch()
+{
+    if (m_prefetchTimeout >= 0) {
+        KIdleTime::instance()->removeIdleTimeout(m_prefetchTimeout);
+        m_prefetchTimeout = -1;
+    }
+
+    if (m_backend->updatesCount() > 0) {
+        m_prefetchTimeout = KIdleTime::instance()->addIdleTimeout(5 * 60 * 1000);
+    } else {
+        setPrefetchedSize(0);
+    }
+}
+
+void PackageKitUpdater::idleTimeoutReached(int identifier)
+{
+    if (identifier == m_prefetchTimeout)
+        prefetch();
+}
+
+void PackageKitUpdater::prefetch()
+{
+    if (!canPrefetch())
+        return;
+
+    const auto candidates = m_backend->upgradeablePackages();
+    auto pkgs = involvedPackages(candidates).values();
+    pkgs.sort();
+    // Already downloaded, PackageKit would only check it again
+    if (pkgs.isEmpty() || pkgs == m_prefetchedPackageIds)
+        return;
+
+    qCDebug(LIBDISCOVER_BACKEND_LOG) << "downloading updates ahead of time" << pkgs.size();
+    m_prefetchTotal = packagesSize(candidates);
+    m_prefetcher = PackageKit::Daemon::updatePackages(pkgs, PackageKit::Transaction::TransactionFlagOnlyTrusted | PackageKit::Transaction::TransactionFlagOnlyDownload);
+    connect(m_prefetcher.data(), &PackageKit::Transaction::downloadSizeRemainingChanged, this, &PackageKitUpdater::prefetchProgressed);
+    connect(m_prefetcher.data(), &PackageKit::Transaction::finished, this, [this, pkgs] (PackageKit::Transaction::Exit exit) {
+        if (exit == PackageKit::Transaction::ExitSuccess) {
+            m_prefetchedPackageIds = pkgs;
+            setPrefetchedSize(m_prefetchTotal);
+        } else {
+            qCDebug(LIBDISCOVER_BACKEND_LOG) << "could not download the updates ahead of time" << exit;
+        }
+        m_prefetcher = nullptr;
+    });
+}
+
+void PackageKitUpdater::prefetchProgressed()
+{
+    // The remaining size is only meaningful once it's downloading
+    if (m_prefetcher->status() != PackageKit::Transaction::StatusDownload)
+        return;
+
+    const double remaining = m_prefetcher->downloadSizeRemaining();
+    setPrefetchedSize(remaining < m_prefetchTotal ? quint64(m_prefetchTotal - remaining) : 0);
+}
+
+void PackageKitUpdater::cancelPrefetch()
+{
+    if (m_prefetchTimeout >= 0) {
+        KIdleTime::instance()->removeIdleTimeout(m_prefetchTimeout);
+        m_prefetchTimeout = -1;
+    }
+    if (m_prefetcher)
+        m_prefetcher->cancel();
+}
@@ -40,6 +40,7 @@ public:
     void fetchChangelog() const override;
     double updateSize() const override;
     quint64 downloadSpeed() const override;
+    quint64 prefetchedSize() const override;
 
     void proceed() override;
     void setOfflineUpdates(bool use) override;
@@ -77,6 +78,15 @@ private:
     void setupTransaction(PackageKit::Transaction::TransactionFlags flags);
     bool useOfflineUpdates() const;
 
+    bool canPrefetch() const;
+    void schedulePrefetch();
+    void idleTimeoutReached(int identifier);
+    void prefetch();
+    void cancelPrefetch();
+    void prefetchProgressed();
+    void setPrefetchedSize(quint64 size);
+    double packagesSize(const QSet<AbstractResource*>& packages) const;
+
     QSet<QString> involvedPackages(const QSet<AbstractResource*>& packages) const;
     QSet<AbstractResource*> packagesForPackageId(const QSet<QString>& packages) const;
 
@@ -93,6 +103,12 @@ private:
     QVector<std::function<PackageKit::Transaction*()>> m_proceedFunctions;
 
     SystemUpgrade* m_upgrade = nullptr;
+
+    QPointer<PackageKit::Transaction> m_prefetcher;
+    int m_prefetchTimeout = -1;
+    QStringList m_prefetchedPackageIds;
+    double m_prefetchTotal = 0.;
+    quint64 m_prefetchedSize = 0;
 };
 
 
@@ -21,14 +21,11 @@
 #include <KConfigGroup>
 #include <KSharedConfig>
 #include <QDebug>
-#include <QThread>
 #include <QTimer>
 #include <QAction>
 #include <QStandardItemModel>
-#include <QtConcurrentMap>
-#include <QtConcurrentRun>
-#include <QFuture>
-#include <QFutureWatcher>
+#include <QPointer>
+#include <QFileSystemWatcher>
 
 #include "utils.h"
 
@@ -84,16 +81,20 @@ SnapBackend::SnapBackend(QObject* parent)
     //make sure we populate the installed resources first
     refreshStates();
 
-    SourcesModel::global()->addSourcesBackend(new SnapSourcesBackend(this));
+    // snapd doesn't notify about changes, but every installed revision has its file in there
+    m_refreshStatesTimer = new QTimer(this);
+    m_refreshStatesTimer->setSingleShot(true);
+    m_refreshStatesTimer->setInterval(1000);
+    connect(m_refreshStatesTimer, &QTimer::timeout, this, &SnapBackend::refreshStates);
+    m_snapsWatcher = new QFileSystemWatcher({ QStringLiteral("/var/lib/snapd/snaps") }, this);
+    connect(m_snapsWatcher, &QFileSystemWatcher::directoryChanged, m_refreshStatesTimer, QOverload<>::of(&QTimer::start));
 
-    m_threadPool.setMaxThreadCount(1);
+    SourcesModel::global()->addSourcesBackend(new SnapSourcesBackend(this));
 }
 
 SnapBackend::~SnapBackend()
 {
     Q_EMIT shuttingDown();
-    m_threadPool.waitForDone(80000);
-    m_threadPool.clear();
 }
 
 int SnapBackend::updatesCount() const
@@ -114,10 +115,7 @@ ResultsStream * SnapBackend::search(const AbstractResourcesBackend::Filters& fil
     } else if (filters.category && filters.category->isAddons()) {
         return voidStream();
     } else if (filters.state >= AbstractResource::Installed || filters.origin == QLatin1String("Snap")) {
-        std::function<bool(const QSharedPointer<QSnapdSnap>&)> f = [filters](const QSharedPointer<QSnapdSnap>& s) {
-            return filters.search.isEmpty() || s->name().contains(filters.search, Qt::CaseInsensitive) || s->description().contains(filters.search, Qt::CaseInsensitive);
-        };
-        return populateWithFilter(m_client.getSnaps(), f);
+        return searchInstalled(filters.search);
     } else if (!filters.search.isEmpty()) {
         return populate(m_client.find(QSnapdClient::FindFlag::None, filters.search));
     }
@@ -152,57 +150,54 @@ ResultsStream* SnapBackend::populate(const QVector<T*>& jobs)
     return populateJobsWithFilter(jobs, acceptAll);
 }
 
-template <class T>
-ResultsStream* SnapBackend::populateWithFilter(T* job, std::function<bool(const QSharedPointer<QSnapdSnap>& s)>& filter)
-{
-    return populateJobsWithFilter<T>({job}, filter);
-}
-
 template <class T>
 ResultsStream* SnapBackend::populateJobsWithFilter(const QVector<T*>& jobs, std::function<bool(const QSharedPointer<QSnapdSnap>& s)>& filter)
 {
+    // All the requests run at once, each one reports its snaps as soon as it completes
     auto stream = new ResultsStream(QStringLiteral("Snap-populate"));
-    auto future = QtConcurrent::run(&m_threadPool, [this, jobs] () {
-        for (auto job : jobs) {
-            connect(this, &SnapBackend::shuttingDown, job, &T::cancel);
-            job->runSync();
-        }
-    });
-
-    auto watcher = new QFutureWatcher<void>(this);
-    watcher->setFuture(future);
-    connect(watcher, &QFutureWatcher<void>::finished, watcher, &QObject::deleteLater);
-    connect(watcher, &QFutureWatcher<void>::finished, stream, [this, jobs, filter, stream] {
-        QVector<AbstractResource*> ret;
-        for (auto job : jobs) {
+    QPointer<ResultsStream> streamPtr(stream);
+    auto remaining = QSharedPointer<int>::create(jobs.size());
+    for (auto job : jobs) {
+        connect(this, &SnapBackend::shuttingDown, job, &T::cancel);
+        connect(job, &QSnapdRequest::complete, this, [this, job, filter, streamPtr, remaining] {
             job->deleteLater();
+            --(*remaining);
+
+            QVector<AbstractResource*> ret;
             if (job->error()) {
                 qDebug() << "error:" << job->error() << job->errorString();
-                continue;
-            }
-
-            for (int i=0, c=job->snapCount(); i<c; ++i) {
-                QSharedPointer<QSnapdSnap> snap(job->snap(i));
-
-                if (!filter(snap))
-                    continue;
-
-                const auto snapname = snap->name();
-                SnapResource*& res = m_resources[snapname];
-                if (!res) {
-                    res = new SnapResource(snap, AbstractResource::None, this);
-                    Q_ASSERT(res->packageName() == snapname);
-                } else {
-                    res->setSnap(snap);
+            } else {
+                for (int i=0, c=job->snapCount(); i<c; ++i) {
+                    QSharedPointer<QSnapdSnap> snap(job->snap(i));
+
+                    if (!filter(snap))
+                        continue;
+
+                    const auto snapname = snap->name();
+                    SnapResource*& res = m_resources[snapname];
+                    if (!res) {
+                        res = new SnapResource(snap, AbstractResource::None, this);
+                        Q_ASSERT(res->packageName() == snapname);
+                    } else {
+                        res->setSnap(snap);
+                    }
+                    ret += res;
                 }
-                ret += res;
             }
-        }
 
-        if (!ret.isEmpty())
-            Q_EMIT stream->resourcesFound(ret);
-        stream->finish();
-    });
+            if (!streamPtr)
+                return;
+            if (!ret.isEmpty())
+                Q_EMIT streamPtr->resourcesFound(ret);
+            if (*remaining == 0)
+                streamPtr->finish();
+        });
+        job->runAsync();
+    }
+
+    if (jobs.isEmpty()) {
+        QTimer::singleShot(0, stream, &ResultsStream::finish);
+    }
     return stream;
 }
 
@@ -249,17 +244,73 @@ QString SnapBackend::displayName() const
     return QStringLiteral("Snap");
 }
 
+ResultsStream* SnapBackend::searchInstalled(const QString &search)
+{
+    auto matching = [this, search] {
+        const QString folded = search.toCaseFolded();
+        QVector<AbstractResource*> ret;
+        for (const auto &installed : qAsConst(m_installed)) {
+            if (folded.isEmpty() || installed.searchText.contains(folded))
+                ret += installed.resource;
+        }
+        return ret;
+    };
+
+    if (m_installedLoaded) {
+        return new ResultsStream(QStringLiteral("Snap-installed"), matching());
+    }
+
+    auto stream = new ResultsStream(QStringLiteral("Snap-installed"));
+    connect(this, &SnapBackend::installedSnapsRefreshed, stream, [stream, matching] {
+        const auto ret = matching();
+        if (!ret.isEmpty())
+            Q_EMIT stream->resourcesFound(ret);
+        stream->finish();
+    });
+    return stream;
+}
+
 void SnapBackend::refreshStates()
 {
+    if (m_refreshingStates) {
+        m_refreshStatesAgain = true;
+        return;
+    }
+
+    m_refreshingStates = true;
     auto ret = new StoredResultsStream({populate(m_client.getSnaps())});
     connect(ret, &StoredResultsStream::finishedResources, this, [this] (const QVector<AbstractResource*>& resources) {
-        for (auto res: qAsConst(m_resources)) {
-            if (resources.contains(res))
-                res->setState(AbstractResource::Installed);
-            else
-                res->setState(AbstractResource::None);
+        setInstalledSnaps(resources);
+
+        m_refreshingStates = false;
+        if (m_refreshStatesAgain) {
+            m_refreshStatesAgain = false;
+            refreshStates();
         }
     });
 }
 
+void SnapBackend::setInstalledSnaps(const QVector<AbstractResource*>& resources)
+{
+    QHash<QString, InstalledSnap> installed;
+    installed.reserve(resources.size());
+    for (auto r : resources) {
+        auto res = qobject_cast<SnapResource*>(r);
+        const auto snap = res->snap();
+        installed.insert(res->packageName(), { res, snap->name().toCaseFolded() + QLatin1Char('\n') + snap->description().toCaseFolded() });
+    }
+
+    for (auto it = m_installed.constBegin(), itEnd = m_installed.constEnd(); it != itEnd; ++it) {
+        if (!installed.contains(it.key()))
+            it->resource->setState(AbstractResource::None);
+    }
+    for (const auto &snap : qAsConst(installed)) {
+        snap.resource->setState(AbstractResource::Installed);
+    }
+
+    m_installed = installed;
+    m_installedLoaded = true;
+    Q_EMIT installedSnapsRefreshed();
+}
+
 #include "SnapBackend.moc"
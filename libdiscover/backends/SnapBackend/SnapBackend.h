@@ -11,13 +11,15 @@
 #include <resources/AbstractResourcesBackend.h>
 #include <QVariantList>
 #include <QVector>
-#include <QThreadPool>
+#include <QSet>
 #include <Snapd/Client>
 #include <functional>
 
 class OdrsReviewsBackend;
 class StandardBackendUpdater;
 class SnapResource;
+class QFileSystemWatcher;
+class QTimer;
 class SnapBackend : public AbstractResourcesBackend
 {
     Q_OBJECT
@@ -53,12 +55,12 @@ public:
 
 Q_SIGNALS:
     void shuttingDown();
+    void installedSnapsRefreshed();
 
 private:
     void setFetching(bool fetching);
-
-    template <class T>
-    ResultsStream* populateWithFilter(T* snaps, std::function<bool(const QSharedPointer<QSnapdSnap>&)>& filter);
+    void setInstalledSnaps(const QVector<AbstractResource*>& resources);
+    ResultsStream* searchInstalled(const QString &search);
 
     template <class T>
     ResultsStream* populateJobsWithFilter(const QVector<T*>& snaps, std::function<bool(const QSharedPointer<QSnapdSnap>&)>& filter);
@@ -70,13 +72,25 @@ private:
     ResultsStream* populate(const QVector<T*>& snaps);
 
     QHash<QString, SnapResource*> m_resources;
+
+    // Snapshot of the installed snaps as of the last refreshStates(), by name along with their
+    // case folded name and description so installed searches don't need to query snapd
+    struct InstalledSnap {
+        SnapResource* resource;
+        QString searchText;
+    };
+    QHash<QString, InstalledSnap> m_installed;
+    bool m_installedLoaded = false;
+    bool m_refreshingStates = false;
+    bool m_refreshStatesAgain = false;
+    QFileSystemWatcher* m_snapsWatcher = nullptr;
+    QTimer* m_refreshStatesTimer = nullptr;
     StandardBackendUpdater* m_updater;
     QSharedPointer<OdrsReviewsBackend> m_reviews;
 
     bool m_valid = true;
     bool m_fetching = false;
     QSnapdClient m_client;
-    QThreadPool m_threadPool;
 };
 
 #endif // SNAPBACKEND_H
@@ -11,3 +11,7 @@ BackendNotifierModule::BackendNotifierModule(QObject* parent)
 {}
 
 BackendNotifierModule::~BackendNotifierModule() = default;
+
+void BackendNotifierModule::prefetchUpdates()
+{
+}
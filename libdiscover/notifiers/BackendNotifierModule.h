@@ -60,6 +60,13 @@ public:
     /** @returns whether the system changed in a way that needs to be rebooted. */
     virtual bool needsReboot() const = 0;
 
+    /**
+     * Downloads the available updates without installing them, so that
+     * applying them later doesn't have to wait for the download.
+     * Does nothing by default.
+     */
+    virtual void prefetchUpdates();
+
 Q_SIGNALS:
     /**
      * This signal is emitted when any new updates are available.
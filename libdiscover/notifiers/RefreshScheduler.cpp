@@ -0,0 +1,108 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "RefreshScheduler.h"
+#include <KConfig>
+#include <KConfigGroup>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QLockFile>
+#include <QStandardPaths>
+
+// Stored as seconds since the epoch, KConfig keeps no time zone for QDateTime and would read it back as local time
+static QDateTime readLastRefresh(const QString &path)
+{
+    const KConfig state(path, KConfig::SimpleConfig);
+    const qint64 last = state.group("Refresh").readEntry<qint64>("LastSecsSinceEpoch", 0);
+    return last > 0 ? QDateTime::fromSecsSinceEpoch(last, Qt::UTC) : QDateTime();
+}
+
+RefreshScheduler::RefreshScheduler(const QString &name, std::chrono::milliseconds period, QObject* parent)
+    : QObject(parent)
+    , m_path(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/discover/refresh/") + name)
+    , m_period(period)
+    , m_lock(new QLockFile(m_path + QLatin1String(".lock")))
+    , m_watcher(new QFileSystemWatcher(this))
+{
+    const QString dir = QFileInfo(m_path).absolutePath();
+    QDir().mkpath(dir);
+
+    // A refresh shouldn't take longer than this, past it the lock is considered abandoned
+    m_lock->setStaleLockTime(30 * 60 * 1000);
+
+    // The state file is replaced when written, watch the directory instead
+    m_watcher->addPath(dir);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &RefreshScheduler::stateChanged);
+    m_lastRefresh = readLastRefresh(m_path);
+}
+
+RefreshScheduler::~RefreshScheduler()
+{
+    if (m_refreshing)
+        m_lock->unlock();
+}
+
+QDateTime RefreshScheduler::lastRefresh() const
+{
+    return m_lastRefresh;
+}
+
+bool RefreshScheduler::isDue() const
+{
+    if (m_refreshing)
+        return false;
+
+    const QDateTime last = readLastRefresh(m_path);
+    return !last.isValid() || last.msecsTo(QDateTime::currentDateTimeUtc()) >= m_period.count();
+}
+
+bool RefreshScheduler::startIfDue()
+{
+    // Someone else is refreshing already if it's locked, we'll hear when they are done
+    if (!isDue() || !m_lock->tryLock(0))
+        return false;
+
+    m_refreshing = true;
+    return true;
+}
+
+void RefreshScheduler::start()
+{
+    if (m_refreshing)
+        return;
+
+    // Requested refreshes go ahead even if another process holds the lock
+    m_refreshing = m_lock->tryLock(0);
+}
+
+void RefreshScheduler::finish(bool success)
+{
+    if (success) {
+        m_lastRefresh = QDateTime::currentDateTimeUtc();
+        KConfig state(m_path, KConfig::SimpleConfig);
+        KConfigGroup group = state.group("Refresh");
+        group.writeEntry<qint64>("LastSecsSinceEpoch", m_lastRefresh.toSecsSinceEpoch());
+        if (!state.sync())
+            qWarning() << "could not store the last refresh" << m_path;
+    }
+
+    if (m_refreshing) {
+        m_refreshing = false;
+        m_lock->unlock();
+    }
+}
+
+void RefreshScheduler::stateChanged()
+{
+    const QDateTime last = readLastRefresh(m_path);
+    if (!last.isValid() || last <= m_lastRefresh)
+        return;
+
+    m_lastRefresh = last;
+    Q_EMIT refreshed();
+}
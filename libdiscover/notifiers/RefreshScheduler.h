@@ -0,0 +1,71 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <chrono>
+#include "discovernotifiers_export.h"
+
+class QFileSystemWatcher;
+class QLockFile;
+
+/**
+ * Coordinates metadata refreshes between every Discover process.
+ *
+ * The notifier and the application each refresh the same metadata. Processes
+ * using a scheduler with the same @p name share when it was last refreshed and
+ * who is refreshing it right now through a state file and a lock file in the
+ * cache directory, so that periodic refreshes only happen once per @p period.
+ */
+class DISCOVERNOTIFIERS_EXPORT RefreshScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    RefreshScheduler(const QString &name, std::chrono::milliseconds period, QObject* parent = nullptr);
+    ~RefreshScheduler() override;
+
+    /// @returns whether the last refresh is older than the period, another process may be refreshing already
+    bool isDue() const;
+
+    /**
+     * Starts a periodic refresh if it's due and no other process is refreshing.
+     * @returns whether the refresh should happen, finish() is due once it's over
+     */
+    bool startIfDue();
+
+    /// Call when starting a refresh that was requested explicitly, it happens even if another process is refreshing
+    void start();
+
+    /// Call once the refresh is over, only a successful one is shared as the last refresh
+    void finish(bool success);
+
+    /// @returns whether start() or startIfDue() were called and finish() wasn't yet
+    bool isRefreshing() const {
+        return m_refreshing;
+    }
+
+    QDateTime lastRefresh() const;
+
+Q_SIGNALS:
+    /// Another process finished refreshing, the results can be read from the updated metadata
+    void refreshed();
+
+private:
+    void stateChanged();
+
+    const QString m_path;
+    const std::chrono::milliseconds m_period;
+    QScopedPointer<QLockFile> m_lock;
+    QFileSystemWatcher* const m_watcher;
+    QDateTime m_lastRefresh;
+    bool m_refreshing = false;
+};
+
+#endif // REFRESHSCHEDULER_H
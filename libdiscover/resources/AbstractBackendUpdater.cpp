@@ -38,6 +38,11 @@ bool AbstractBackendUpdater::needsReboot() const
     return m_needsReboot;
 }
 
+quint64 AbstractBackendUpdater::prefetchedSize() const
+{
+    return 0;
+}
+
 void AbstractBackendUpdater::setOfflineUpdates(bool useOfflineUpdates)
 {
     Q_UNUSED(useOfflineUpdates);
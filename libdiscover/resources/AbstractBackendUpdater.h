@@ -44,6 +44,7 @@ class DISCOVERCOMMON_EXPORT AbstractBackendUpdater : public QObject
     Q_PROPERTY(bool isProgressing READ isProgressing NOTIFY progressingChanged)
     Q_PROPERTY(bool needsReboot READ needsReboot NOTIFY needsRebootChanged)
     Q_PROPERTY(quint64 downloadSpeed READ downloadSpeed NOTIFY downloadSpeedChanged)
+    Q_PROPERTY(quint64 prefetchedSize READ prefetchedSize NOTIFY prefetchedSizeChanged)
 public:
     enum State { None, Downloading, Installing, Done };
     Q_ENUM(State);
@@ -121,6 +122,12 @@ public:
      */
     virtual quint64 downloadSpeed() const = 0;
 
+    /**
+     * @returns how many bytes of the available updates have already been
+     * downloaded in the background, so that they only need to be installed
+     */
+    virtual quint64 prefetchedSize() const;
+
     void enableNeedsReboot();
 
     bool needsReboot() const;
@@ -184,6 +191,11 @@ Q_SIGNALS:
      * @see downloadSpeed
      */
     void downloadSpeedChanged(quint64 downloadSpeed);
+    /**
+     * The AbstractBackendUpdater should emit this signal when the prefetched size changed.
+     * @see prefetchedSize
+     */
+    void prefetchedSizeChanged();
 
     /**
      * Provides the @p progress of a specific @p resource in a percentage.
@@ -91,6 +91,16 @@ Transaction* AbstractResourcesBackend::installApplication(AbstractResource* app)
     return installApplication(app, AddonList());
 }
 
+QVector<Transaction*> AbstractResourcesBackend::installApplications(const QVector<AbstractResource*>& apps)
+{
+    QVector<Transaction*> ret;
+    for (auto app : apps) {
+        if (auto t = installApplication(app))
+            ret += t;
+    }
+    return ret;
+}
+
 void AbstractResourcesBackend::setName(const QString& name)
 {
     m_name = name;
@@ -139,6 +149,16 @@ void AbstractResourcesBackend::Filters::filterJustInCase(QVector<AbstractResourc
     }
 }
 
+bool AbstractResourcesBackend::isSearchPrefixMonotonic() const
+{
+    return false;
+}
+
+bool AbstractResourcesBackend::searchMatches(AbstractResource* resource, const QString &search) const
+{
+    return resource->name().contains(search, Qt::CaseInsensitive) || resource->comment().contains(search, Qt::CaseInsensitive);
+}
+
 QStringList AbstractResourcesBackend::extends() const
 {
     return {};
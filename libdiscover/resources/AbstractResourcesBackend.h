@@ -109,6 +109,21 @@ public:
 
     virtual ResultsStream* search(const Filters &search) = 0;//FIXME: Probably provide a standard implementation?!
 
+    /**
+     * @returns true if searching for a text only ever finds resources that were also found
+     * when searching for any prefix of it, as long as the rest of the filters are the same.
+     *
+     * This allows refining searches as the user types without querying the backend again,
+     * by checking the resources found so far with searchMatches().
+     */
+    virtual bool isSearchPrefixMonotonic() const;
+
+    /**
+     * @returns whether @p resource matches the @p search text, as search() would check it
+     * By default the name and the comment are checked.
+     */
+    virtual bool searchMatches(AbstractResource* resource, const QString &search) const;
+
     /**
      * @returns the reviews backend of this AbstractResourcesBackend (which handles all ratings and reviews of resources)
      */
@@ -184,6 +199,13 @@ public Q_SLOTS:
      */
     virtual Transaction* installApplication(AbstractResource *app);
 
+    /**
+     * Installs all of @p apps, backends that can process them together should do so.
+     * By default it's the same as calling installApplication() on each of them.
+     * @returns a Transaction for every one of the @p apps that is being installed
+     */
+    virtual QVector<Transaction*> installApplications(const QVector<AbstractResource*> &apps);
+
     /**
      * This gets called when the backend should remove an application.
      * Like in the installApplication() method, we'll return the Transaction
@@ -0,0 +1,90 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "ProgressAggregator.h"
+#include <QTimer>
+
+ProgressAggregator::ProgressAggregator(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(FlushInterval);
+    connect(m_timer, &QTimer::timeout, this, &ProgressAggregator::flush);
+}
+
+void ProgressAggregator::setProgress(QObject* source, qreal progress)
+{
+    auto it = m_values.find(source);
+    if (it == m_values.end()) {
+        it = m_values.insert(source, 0.);
+        connect(source, &QObject::destroyed, this, &ProgressAggregator::sourceDestroyed);
+    }
+
+    m_total += progress - *it;
+    *it = progress;
+    m_pending.insert(source);
+    scheduleFlush();
+}
+
+void ProgressAggregator::remove(QObject* source)
+{
+    const auto it = m_values.find(source);
+    if (it == m_values.end())
+        return;
+
+    disconnect(source, &QObject::destroyed, this, &ProgressAggregator::sourceDestroyed);
+    m_total -= *it;
+    m_values.erase(it);
+    m_pending.remove(source);
+    scheduleFlush();
+}
+
+void ProgressAggregator::clear()
+{
+    for (auto it = m_values.constBegin(), end = m_values.constEnd(); it != end; ++it) {
+        disconnect(it.key(), &QObject::destroyed, this, &ProgressAggregator::sourceDestroyed);
+    }
+    m_values.clear();
+    m_pending.clear();
+    m_total = 0.;
+    scheduleFlush();
+}
+
+void ProgressAggregator::sourceDestroyed(QObject* source)
+{
+    const auto it = m_values.find(source);
+    if (it == m_values.end())
+        return;
+
+    m_total -= *it;
+    m_values.erase(it);
+    m_pending.remove(source);
+    scheduleFlush();
+}
+
+void ProgressAggregator::scheduleFlush()
+{
+    m_changed = true;
+    // Not restarted, otherwise a busy source would keep postponing it
+    if (!m_timer->isActive())
+        m_timer->start();
+}
+
+void ProgressAggregator::flush()
+{
+    m_timer->stop();
+    if (!m_changed)
+        return;
+
+    const auto pending = m_pending;
+    m_pending.clear();
+    m_changed = false;
+    for (QObject* source : pending) {
+        Q_EMIT sourceProgressed(source, m_values.value(source));
+    }
+    Q_EMIT progressChanged();
+}
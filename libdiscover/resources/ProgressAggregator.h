@@ -0,0 +1,67 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef PROGRESSAGGREGATOR_H
+#define PROGRESSAGGREGATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include "discovercommon_export.h"
+
+class QTimer;
+
+/**
+ * Collects the progress reported by many sources, usually transactions, and
+ * lets the UI know about it at most once per frame.
+ *
+ * Only the latest value of every source is kept and the total is updated as
+ * values come in, so reading it doesn't depend on how many sources there are.
+ * Sources are forgotten when they are destroyed.
+ */
+class DISCOVERCOMMON_EXPORT ProgressAggregator : public QObject
+{
+    Q_OBJECT
+public:
+    /// How long progress is collected before it's notified, about 60 frames per second, nobody sees progress bars move faster
+    static constexpr int FlushInterval = 16;
+
+    explicit ProgressAggregator(QObject* parent = nullptr);
+
+    /// Records the latest @p progress of @p source, it's notified on the next frame even if it didn't change
+    void setProgress(QObject* source, qreal progress);
+    void remove(QObject* source);
+    void clear();
+
+    bool contains(QObject* source) const { return m_values.contains(source); }
+    qreal progress(QObject* source) const { return m_values.value(source); }
+    int count() const { return m_values.count(); }
+
+    /// @returns the sum of the progress of all the sources
+    qreal total() const { return m_total; }
+    qreal average() const { return m_values.isEmpty() ? 0. : m_total / m_values.count(); }
+
+    /// Notifies right away of what is pending instead of waiting for the next frame
+    void flush();
+
+Q_SIGNALS:
+    /// Emitted once per frame for every source that reported progress since the previous one
+    void sourceProgressed(QObject* source, qreal progress);
+    /// Emitted once per frame if anything changed, after sourceProgressed
+    void progressChanged();
+
+private:
+    void sourceDestroyed(QObject* source);
+    void scheduleFlush();
+
+    QHash<QObject*, qreal> m_values;
+    QSet<QObject*> m_pending;
+    qreal m_total = 0.;
+    bool m_changed = false;
+    QTimer* const m_timer;
+};
+
+#endif // PROGRESSAGGREGATOR_H
@@ -10,6 +10,8 @@
 #include "AbstractResource.h"
 #include "resources/AbstractResourcesBackend.h"
 #include "resources/AbstractBackendUpdater.h"
+#include "resources/ProgressAggregator.h"
+#include "resources/UpdatesChecker.h"
 #include <ReviewsBackend/Rating.h>
 #include <ReviewsBackend/AbstractReviewsBackend.h>
 #include <Transaction/Transaction.h>
@@ -42,6 +44,8 @@ ResourcesModel::ResourcesModel(QObject* parent, bool load)
     , m_initializingBackends(0)
     , m_currentApplicationBackend(nullptr)
     , m_allInitializedEmitter(new QTimer(this))
+    , m_backendsUpdatesProgress(new ProgressAggregator(this))
+    , m_updatesChecker(new UpdatesChecker(this))
     , m_updatesCount(0, [this] {
     {
         int ret = 0;
@@ -58,11 +62,7 @@ ResourcesModel::ResourcesModel(QObject* parent, bool load)
         if (m_backends.isEmpty())
             return 0;
 
-        int sum = 0;
-        for (auto backend: qAsConst(m_backends)) {
-            sum += backend->fetchingUpdatesProgress();
-        }
-        return sum / m_backends.count();
+        return int(m_backendsUpdatesProgress->total()) / m_backends.count();
     }
 }, [this](int progress) {
     Q_EMIT fetchingUpdatesProgressChanged(progress);
@@ -71,6 +71,13 @@ ResourcesModel::ResourcesModel(QObject* parent, bool load)
     init(load);
     connect(this, &ResourcesModel::allInitialized, this, &ResourcesModel::slotFetching);
     connect(this, &ResourcesModel::backendsChanged, this, &ResourcesModel::initApplicationsBackend);
+
+    // Updates are published as every backend is done, the slow ones don't hold back the rest past the deadline
+    connect(m_updatesChecker, &UpdatesChecker::backendChecked, this, [this] {
+        m_updatesCount.reevaluate();
+        slotFetching();
+    });
+    connect(m_updatesChecker, &UpdatesChecker::finished, this, &ResourcesModel::slotFetching);
 }
 
 void ResourcesModel::init(bool load)
@@ -94,6 +101,12 @@ void ResourcesModel::init(bool load)
     m_updateAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_R));
     connect(this, &ResourcesModel::fetchingChanged, m_updateAction, [this](bool fetching) {
         m_updateAction->setEnabled(!fetching);
+        for (auto backend : qAsConst(m_backends)) {
+            m_backendsUpdatesProgress->setProgress(backend, backend->fetchingUpdatesProgress());
+        }
+    });
+    // Backends report their progress as often as they get it, sum it up once per frame
+    connect(m_backendsUpdatesProgress, &ProgressAggregator::progressChanged, this, [this] {
         m_fetchingUpdatesProgress.reevaluate();
     });
     connect(m_updateAction, &QAction::triggered, this, &ResourcesModel::checkForUpdates);
@@ -124,6 +137,7 @@ void ResourcesModel::addResourcesBackend(AbstractResourcesBackend* backend)
     }
 
     m_backends += backend;
+    m_backendsUpdatesProgress->setProgress(backend, backend->fetchingUpdatesProgress());
     if (!backend->isFetching()) {
         m_updatesCount.reevaluate();
     } else {
@@ -134,7 +148,9 @@ void ResourcesModel::addResourcesBackend(AbstractResourcesBackend* backend)
     connect(backend, &AbstractResourcesBackend::allDataChanged, this, &ResourcesModel::updateCaller);
     connect(backend, &AbstractResourcesBackend::resourcesChanged, this, &ResourcesModel::resourceDataChanged);
     connect(backend, &AbstractResourcesBackend::updatesCountChanged, this, [this] { m_updatesCount.reevaluate(); });
-    connect(backend, &AbstractResourcesBackend::fetchingUpdatesProgressChanged, this, [this] { m_fetchingUpdatesProgress.reevaluate(); });
+    connect(backend, &AbstractResourcesBackend::fetchingUpdatesProgressChanged, this, [this, backend] {
+        m_backendsUpdatesProgress->setProgress(backend, backend->fetchingUpdatesProgress());
+    });
     connect(backend, &AbstractResourcesBackend::resourceRemoved, this, &ResourcesModel::resourceRemoved);
     connect(backend, &AbstractResourcesBackend::passiveMessage, this, &ResourcesModel::passiveMessage);
     connect(backend->backendUpdater(), &AbstractBackendUpdater::progressingChanged, this, &ResourcesModel::slotFetching);
@@ -176,6 +192,7 @@ void ResourcesModel::callerFetchingChanged()
         int idx = m_backends.indexOf(backend);
         Q_ASSERT(idx>=0);
         m_backends.removeAt(idx);
+        m_backendsUpdatesProgress->remove(backend);
         Q_EMIT backendsChanged();
         CategoryModel::global()->blacklistPlugin(backend->name());
         backend->deleteLater();
@@ -285,6 +302,11 @@ void ResourcesModel::slotFetching()
         // will still be operating on things, which from a model point of view would
         // still mean something going on. So, interpret that as fetching as well, for
         // the purposes of this property.
+        // Backends that missed the deadline of the updates check don't count, they are waited on
+        // for long enough.
+        if (m_updatesChecker->isLate(b)) {
+            continue;
+        }
         if (b->isFetching() || (b->backendUpdater() && b->backendUpdater()->isProgressing())) {
             newFetching = true;
             break;
@@ -377,11 +399,16 @@ void AggregatedResultsStream::clear()
 
 AggregatedResultsStream* ResourcesModel::search(const AbstractResourcesBackend::Filters& search)
 {
-    if (search.isEmpty() || networkState() == "1") {
+    return this->search(search, m_backends);
+}
+
+AggregatedResultsStream* ResourcesModel::search(const AbstractResourcesBackend::Filters& search, const QVector<AbstractResourcesBackend*>& backends)
+{
+    if (search.isEmpty() || backends.isEmpty() || networkState() == "1") {
         return new AggregatedResultsStream ({new ResultsStream(QStringLiteral("emptysearch"), {})});
     }
 
-    auto streams = kTransform<QSet<ResultsStream*>>(m_backends, [search](AbstractResourcesBackend* backend) {
+    auto streams = kTransform<QSet<ResultsStream*>>(backends, [search](AbstractResourcesBackend* backend) {
         return backend->search(search);
     });
     return new AggregatedResultsStream(streams);
@@ -389,8 +416,7 @@ AggregatedResultsStream* ResourcesModel::search(const AbstractResourcesBackend::
 
 void ResourcesModel::checkForUpdates()
 {
-    for (auto backend: qAsConst(m_backends))
-        backend->checkForUpdates();
+    m_updatesChecker->start(m_backends);
 }
 
 void ResourcesModel::refreshCache()
@@ -13,9 +13,11 @@
 
 #include "discovercommon_export.h"
 #include "AbstractResourcesBackend.h"
+#include "UpdatesChecker.h"
 #include <network/networkutils.h>
 
 class QAction;
+class ProgressAggregator;
 
 class DISCOVERCOMMON_EXPORT AggregatedResultsStream : public ResultsStream
 {
@@ -75,6 +77,7 @@ class DISCOVERCOMMON_EXPORT ResourcesModel : public QObject
     Q_PROPERTY(QVariantList backends READ backendsVariant NOTIFY backendsChanged)
     Q_PROPERTY(AbstractResourcesBackend* currentApplicationBackend READ currentApplicationBackend WRITE setCurrentApplicationBackend NOTIFY currentApplicationBackendChanged)
     Q_PROPERTY(QAction* updateAction READ updateAction CONSTANT)
+    Q_PROPERTY(UpdatesChecker* updatesChecker READ updatesChecker CONSTANT)
     Q_PROPERTY(int fetchingUpdatesProgress READ fetchingUpdatesProgress NOTIFY fetchingUpdatesProgressChanged)
     Q_PROPERTY(QString applicationSourceName READ applicationSourceName NOTIFY currentApplicationBackendChanged)
     Q_PROPERTY(QString networkState READ networkState NOTIFY networkStateChanged)
@@ -100,9 +103,15 @@ public:
     Q_SCRIPTABLE bool isExtended(const QString &id);
 
     AggregatedResultsStream* search(const AbstractResourcesBackend::Filters &search);
+    AggregatedResultsStream* search(const AbstractResourcesBackend::Filters &search, const QVector<AbstractResourcesBackend*> &backends);
     void checkForUpdates();
     void refreshCache();
 
+    /// Follows the last checkForUpdates(), reporting what every backend found as soon as it's done
+    UpdatesChecker* updatesChecker() const {
+        return m_updatesChecker;
+    }
+
     QString applicationSourceName() const;
 
     QVariantList backendsVariant() const;
@@ -161,6 +170,8 @@ private:
     QAction* m_updateAction = nullptr;
     AbstractResourcesBackend* m_currentApplicationBackend;
     QTimer* m_allInitializedEmitter;
+    ProgressAggregator* const m_backendsUpdatesProgress;
+    UpdatesChecker* const m_updatesChecker;
 
     EmitWhenChanged<int> m_updatesCount;
     EmitWhenChanged<int> m_fetchingUpdatesProgress;
@@ -14,8 +14,17 @@
 #include "ResourcesModel.h"
 #include <Category/CategoryModel.h>
 #include <ReviewsBackend/Rating.h>
+#include <ReviewsBackend/AbstractReviewsBackend.h>
 #include <Transaction/TransactionModel.h>
 #include <QNetworkConfigurationManager>
+#include <QFutureWatcher>
+#include <QTimer>
+
+static bool isRatingRole(int role)
+{
+    return role == ResourcesProxyModel::RatingRole || role == ResourcesProxyModel::RatingPointsRole
+        || role == ResourcesProxyModel::RatingCountRole || role == ResourcesProxyModel::SortableRatingRole;
+}
 
 ResourcesProxyModel::ResourcesProxyModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -47,7 +56,12 @@ ResourcesProxyModel::ResourcesProxyModel(QObject *parent)
     { ReleaseDateRole, "releaseDate" }
 })
 , m_currentStream(nullptr)
+, m_searchTimer(new QTimer(this))
 {
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(200);
+    connect(m_searchTimer, &QTimer::timeout, this, &ResourcesProxyModel::applySearch);
+
 //     new QAbstractItemModelTester(this, this);
 
     connect(ResourcesModel::global(), &ResourcesModel::backendsChanged, this, &ResourcesProxyModel::invalidateFilter);
@@ -64,6 +78,9 @@ void ResourcesProxyModel::componentComplete()
 {
     m_setup = true;
     invalidateFilter();
+    if (isRatingRole(m_sortRole)) {
+        sortWhenRatingsReady();
+    }
 }
 
 QHash<int, QByteArray> ResourcesProxyModel::roleNames() const
@@ -79,9 +96,50 @@ void ResourcesProxyModel::setSortRole(Roles sortRole)
         m_sortRole = sortRole;
         Q_EMIT sortRoleChanged(sortRole);
         invalidateSorting();
+        if (isRatingRole(sortRole)) {
+            sortWhenRatingsReady();
+        }
     }
 }
 
+void ResourcesProxyModel::sortWhenRatingsReady()
+{
+    const auto backends = ResourcesModel::global()->backends();
+    for (auto backend : backends) {
+        AbstractReviewsBackend* reviews = backend->reviewsBackend();
+        if (!reviews || m_awaitingRatings.contains(reviews))
+            continue;
+
+        const QFuture<void> ratings = reviews->ratingsFuture();
+        if (ratings.isFinished())
+            continue;
+
+        m_awaitingRatings.insert(reviews);
+        auto fw = new QFutureWatcher<void>(this);
+        connect(fw, &QFutureWatcher<void>::finished, this, [this, fw, reviews] {
+            m_awaitingRatings.remove(reviews);
+            if (isRatingRole(m_sortRole)) {
+                scheduleSorting();
+            }
+            fw->deleteLater();
+        });
+        fw->setFuture(ratings);
+    }
+}
+
+void ResourcesProxyModel::scheduleSorting()
+{
+    // Several backends can report new values at once, sort only once for all of them
+    if (m_sortingScheduled)
+        return;
+
+    m_sortingScheduled = true;
+    QTimer::singleShot(0, this, [this] {
+        m_sortingScheduled = false;
+        invalidateSorting();
+    });
+}
+
 void ResourcesProxyModel::setSortOrder(Qt::SortOrder sortOrder)
 {
     if (sortOrder != m_sortOrder) {
@@ -104,11 +162,84 @@ void ResourcesProxyModel::setSearch(const QString &_searchText)
             m_sortByRelevancy = !searchText.isEmpty();
             Q_EMIT sortByRelevancyChanged(m_sortByRelevancy);
         }
-        invalidateFilter();
         Q_EMIT searchChanged(m_filters.search);
+
+        if (m_searchTimer->interval() > 0 && !searchText.isEmpty()) {
+            m_searchPending = true;
+            m_searchTimer->start();
+            updateBusy();
+        } else {
+            applySearch();
+        }
+    }
+}
+
+int ResourcesProxyModel::searchDelay() const
+{
+    return m_searchTimer->interval();
+}
+
+void ResourcesProxyModel::setSearchDelay(int delay)
+{
+    if (delay != m_searchTimer->interval()) {
+        m_searchTimer->setInterval(delay);
+        Q_EMIT searchDelayChanged(delay);
     }
 }
 
+void ResourcesProxyModel::applySearch()
+{
+    m_searchTimer->stop();
+    if (m_filters.search != m_queriedSearch && !refineSearch())
+        invalidateFilter();
+
+    m_searchPending = false;
+    updateBusy();
+}
+
+bool ResourcesProxyModel::refineSearch()
+{
+    // Only complete results can be refined, and only if the text was extended
+    if (!m_setup || m_currentStream || m_queriedSearch.isEmpty() || !m_filters.resourceUrl.isEmpty()
+        || !m_filters.search.startsWith(m_queriedSearch, Qt::CaseInsensitive)) {
+        return false;
+    }
+
+    const auto backends = ResourcesModel::global()->backends();
+    const auto requery = kFilter<QVector<AbstractResourcesBackend*>>(backends, [](AbstractResourcesBackend* backend) {
+        return !backend->isSearchPrefixMonotonic();
+    });
+    if (requery.count() == backends.count()) {
+        return false;
+    }
+
+    // Keep what still matches from the backends that can tell, the rest is queried again
+    const QString search = m_filters.search;
+    m_queriedSearch = search;
+    const auto keep = kTransform<QVector<bool>>(m_displayedResources, [&search](AbstractResource* res) {
+        AbstractResourcesBackend* backend = res->backend();
+        return backend->isSearchPrefixMonotonic() && backend->searchMatches(res, search);
+    });
+    for (int i = m_displayedResources.count() - 1; i >= 0; ) {
+        if (keep[i]) {
+            --i;
+            continue;
+        }
+
+        const int last = i;
+        while (i >= 0 && !keep[i])
+            --i;
+        beginRemoveRows({}, i + 1, last);
+        m_displayedResources.remove(i + 1, last - i);
+        endRemoveRows();
+    }
+
+    if (!requery.isEmpty()) {
+        setCurrentStream(ResourcesModel::global()->search(m_filters, requery));
+    }
+    return true;
+}
+
 void ResourcesProxyModel::removeDuplicates(QVector<AbstractResource *>& resources)
 {
     const auto cab = ResourcesModel::global()->currentApplicationBackend();
@@ -317,10 +448,10 @@ void ResourcesProxyModel::invalidateFilter()
     if (m_currentStream) {
         qCWarning(LIBDISCOVER_LOG) << "last stream isn't over yet" << m_filters << this;
         delete m_currentStream;
+        m_currentStream = nullptr;
     }
 
-    m_currentStream = ResourcesModel::global()->search(m_filters);
-    Q_EMIT busyChanged(true);
+    m_queriedSearch = m_filters.search;
 
     if (!m_displayedResources.isEmpty()) {
         beginResetModel();
@@ -328,14 +459,31 @@ void ResourcesProxyModel::invalidateFilter()
         endResetModel();
     }
 
+    setCurrentStream(ResourcesModel::global()->search(m_filters));
+}
+
+void ResourcesProxyModel::setCurrentStream(AggregatedResultsStream* stream)
+{
+    m_currentStream = stream;
+    updateBusy();
+
     connect(m_currentStream, &AggregatedResultsStream::resourcesFound, this, &ResourcesProxyModel::addResources);
     connect(m_currentStream, &AggregatedResultsStream::finished, this, [this]() {
         m_currentStream = nullptr;
         qDebug()<<Q_FUNC_INFO << " busy finished:" << m_currentStream;
-        Q_EMIT busyChanged(false);
+        updateBusy();
     });
 }
 
+void ResourcesProxyModel::updateBusy()
+{
+    const bool busy = m_currentStream || m_searchPending;
+    if (busy != m_busy) {
+        m_busy = busy;
+        Q_EMIT busyChanged(busy);
+    }
+}
+
 int ResourcesProxyModel::rowCount(const QModelIndex& parent) const
 {
     return parent.isValid() ? 0 : m_displayedResources.count();
@@ -614,7 +762,7 @@ void ResourcesProxyModel::refreshBackend(AbstractResourcesBackend* backend, cons
     }
 
     if (found && properties.contains(m_roles.value(m_sortRole))) {
-        invalidateSorting();
+        scheduleSorting();
     }
 }
 
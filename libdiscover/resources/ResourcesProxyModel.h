@@ -11,6 +11,7 @@
 #include <QSortFilterProxyModel>
 #include <QString>
 #include <QStringList>
+#include <QSet>
 #include <QQmlParserStatus>
 
 #include <Category/Category.h>
@@ -20,6 +21,8 @@
 #include "AbstractResourcesBackend.h"
 
 class AggregatedResultsStream;
+class AbstractReviewsBackend;
+class QTimer;
 
 class DISCOVERCOMMON_EXPORT ResourcesProxyModel : public QAbstractListModel, public QQmlParserStatus
 {
@@ -33,6 +36,7 @@ class DISCOVERCOMMON_EXPORT ResourcesProxyModel : public QAbstractListModel, pub
     Q_PROPERTY(bool filterMinimumState READ filterMinimumState WRITE setFilterMinimumState NOTIFY filterMinimumStateChanged)
     Q_PROPERTY(QString mimeTypeFilter READ mimeTypeFilter WRITE setMimeTypeFilter)
     Q_PROPERTY(QString search READ lastSearch WRITE setSearch NOTIFY searchChanged)
+    Q_PROPERTY(int searchDelay READ searchDelay WRITE setSearchDelay NOTIFY searchDelayChanged)
     Q_PROPERTY(QUrl resourcesUrl READ resourcesUrl WRITE setResourcesUrl NOTIFY resourcesUrlChanged)
     Q_PROPERTY(QString extending READ extends WRITE setExtends)
     Q_PROPERTY(bool allBackends READ allBackends WRITE setAllBackends)
@@ -72,6 +76,9 @@ public:
 
     void setSearch(const QString &text);
     QString lastSearch() const;
+    /// Time in milliseconds we wait for the search text to settle before searching
+    int searchDelay() const;
+    void setSearchDelay(int delay);
     void setOriginFilter(const QString &origin);
     QString originFilter() const;
     void setFiltersFromCategory(Category *category);
@@ -112,7 +119,7 @@ public:
     Q_SCRIPTABLE AbstractResource* findIndexByName(QString appName);
 
     bool isBusy() const {
-        return m_currentStream != nullptr;
+        return m_busy;
     }
 
     bool lessThan(AbstractResource* rl, AbstractResource* rr) const;
@@ -137,6 +144,12 @@ private:
     QVector<int> propertiesToRoles(const QVector<QByteArray>& properties) const;
     void addResources(const QVector<AbstractResource*> &res);
     void fetchSubcategories();
+    void sortWhenRatingsReady();
+    void applySearch();
+    bool refineSearch();
+    void setCurrentStream(AggregatedResultsStream* stream);
+    void updateBusy();
+    void scheduleSorting();
     void removeDuplicates(QVector<AbstractResource *>& newResources);
     bool isSorted(const QVector<AbstractResource*> & resources);
 
@@ -145,6 +158,14 @@ private:
 
     bool m_sortByRelevancy;
     bool m_setup = false;
+    bool m_sortingScheduled = false;
+    bool m_busy = false;
+    // Set while the search text is settling, we're already busy then
+    bool m_searchPending = false;
+    QTimer* const m_searchTimer;
+    // The search text the displayed resources were queried for
+    QString m_queriedSearch;
+    QSet<AbstractReviewsBackend*> m_awaitingRatings;
 
     AbstractResourcesBackend::Filters m_filters;
     QVariantList m_subcategories;
@@ -160,6 +181,7 @@ Q_SIGNALS:
     void categoryChanged();
     void stateFilterChanged();
     void searchChanged(const QString &search);
+    void searchDelayChanged(int delay);
     void subcategoriesChanged(const QVariantList &subcategories);
     void resourcesUrlChanged(const QUrl &url);
     void countChanged();
@@ -10,6 +10,7 @@
 #include "ResourcesModel.h"
 #include "AbstractBackendUpdater.h"
 #include "AbstractResource.h"
+#include "ProgressAggregator.h"
 #include "utils.h"
 #include "libdiscover_debug.h"
 
@@ -26,12 +27,17 @@ public:
     UpdateTransaction(ResourcesUpdatesModel* /*parent*/, const QVector<AbstractBackendUpdater*> &updaters)
         : Transaction(nullptr, nullptr, Transaction::InstallRole)
         , m_allUpdaters(updaters)
+        , m_progress(new ProgressAggregator(this))
     {
         bool cancelable = false;
+        connect(m_progress, &ProgressAggregator::progressChanged, this, &UpdateTransaction::slotUpdateProgress);
         foreach (auto updater, m_allUpdaters) {
+            m_progress->setProgress(updater, updater->progress());
             connect(updater, &AbstractBackendUpdater::progressingChanged, this, &UpdateTransaction::slotProgressingChanged);
             connect(updater, &AbstractBackendUpdater::downloadSpeedChanged, this, &UpdateTransaction::slotDownloadSpeedChanged);
-            connect(updater, &AbstractBackendUpdater::progressChanged, this, &UpdateTransaction::slotUpdateProgress);
+            connect(updater, &AbstractBackendUpdater::progressChanged, this, [this, updater] (qreal progress) {
+                m_progress->setProgress(updater, progress);
+            });
             connect(updater, &AbstractBackendUpdater::proceedRequest, this, &UpdateTransaction::processProceedRequest);
             connect(updater, &AbstractBackendUpdater::cancelableChanged, this, [this](bool) {
                 setCancellable(kContains(m_allUpdaters, [] (AbstractBackendUpdater* updater) {
@@ -80,11 +86,7 @@ public:
 
     void slotUpdateProgress()
     {
-        qreal total = 0;
-        foreach (AbstractBackendUpdater* updater, m_allUpdaters) {
-            total += updater->progress();
-        }
-        setProgress(total / m_allUpdaters.count());
+        setProgress(m_progress->total() / m_allUpdaters.count());
     }
 
     void slotDownloadSpeedChanged()
@@ -109,6 +111,7 @@ Q_SIGNALS:
 private:
     QVector<AbstractBackendUpdater*> m_updatersWaitingForFeedback;
     const QVector<AbstractBackendUpdater*> m_allUpdaters;
+    ProgressAggregator* const m_progress;
 };
 
 ResourcesUpdatesModel::ResourcesUpdatesModel(QObject* parent)
@@ -131,6 +134,7 @@ void ResourcesUpdatesModel::init()
             connect(updater, &AbstractBackendUpdater::statusMessageChanged, this, &ResourcesUpdatesModel::message);
             connect(updater, &AbstractBackendUpdater::statusDetailChanged, this, &ResourcesUpdatesModel::message);
             connect(updater, &AbstractBackendUpdater::downloadSpeedChanged, this, &ResourcesUpdatesModel::downloadSpeedChanged);
+            connect(updater, &AbstractBackendUpdater::prefetchedSizeChanged, this, &ResourcesUpdatesModel::prefetchedSizeChanged);
             connect(updater, &AbstractBackendUpdater::resourceProgressed, this, &ResourcesUpdatesModel::resourceProgressed);
             connect(updater, &AbstractBackendUpdater::passiveMessage, this, &ResourcesUpdatesModel::passiveMessage);
             connect(updater, &AbstractBackendUpdater::needsRebootChanged, this, &ResourcesUpdatesModel::needsRebootChanged);
@@ -285,6 +289,15 @@ double ResourcesUpdatesModel::updateSize() const
     return ret;
 }
 
+quint64 ResourcesUpdatesModel::prefetchedSize() const
+{
+    quint64 ret = 0;
+    for (AbstractBackendUpdater* upd: m_updaters) {
+        ret += upd->prefetchedSize();
+    }
+    return ret;
+}
+
 qint64 ResourcesUpdatesModel::secsToLastUpdate() const
 {
     return lastUpdate().secsTo(QDateTime::currentDateTime());
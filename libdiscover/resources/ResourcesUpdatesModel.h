@@ -25,6 +25,7 @@ class DISCOVERCOMMON_EXPORT ResourcesUpdatesModel : public QStandardItemModel
     Q_PROPERTY(qint64 secsToLastUpdate READ secsToLastUpdate NOTIFY progressingChanged)
     Q_PROPERTY(Transaction* transaction READ transaction NOTIFY progressingChanged)
     Q_PROPERTY(bool needsReboot READ needsReboot NOTIFY needsRebootChanged)
+    Q_PROPERTY(quint64 prefetchedSize READ prefetchedSize NOTIFY prefetchedSizeChanged)
 public:
     explicit ResourcesUpdatesModel(QObject* parent = nullptr);
 
@@ -35,6 +36,8 @@ public:
     QList<AbstractResource*> toUpdate() const;
     QDateTime lastUpdate() const;
     double updateSize() const;
+    /// @returns how much of the updates has been downloaded ahead of time, in bytes
+    quint64 prefetchedSize() const;
     void addResources(const QList<AbstractResource*>& resources);
     void removeResources(const QList<AbstractResource*>& resources);
     Q_SCRIPTABLE void updateResource(AbstractResource* resources);
@@ -48,6 +51,7 @@ public:
 
 Q_SIGNALS:
     void downloadSpeedChanged();
+    void prefetchedSizeChanged();
     void progressingChanged();
     void finished();
     void resourceProgressed(AbstractResource* resource, qreal progress, AbstractBackendUpdater::State state);
@@ -0,0 +1,344 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "SearchIndex.h"
+#include "AbstractResource.h"
+
+#include <algorithm>
+#include <cmath>
+
+// BM25 parameters, the usual ones
+static const double s_k1 = 1.2;
+static const double s_b = 0.75;
+
+// How much each field counts towards the term frequency
+static const float s_idWeight = 1;
+static const float s_nameWeight = 3;
+static const float s_keywordsWeight = 2;
+static const float s_categoriesWeight = 1;
+static const float s_summaryWeight = 1;
+
+// Matching part of a word is worth less than matching the whole word, more so if it's not its beginning
+static const double s_prefixWeight = 0.6;
+static const double s_infixWeight = 0.3;
+// Looking for the exact id of a resource always puts it first
+static const double s_idBonus = 1000;
+
+static bool isCjk(uint ucs4)
+{
+    switch (QChar::script(ucs4)) {
+    case QChar::Script_Han:
+    case QChar::Script_Bopomofo:
+    case QChar::Script_Hiragana:
+    case QChar::Script_Katakana:
+    case QChar::Script_Hangul:
+        return true;
+    default:
+        return false;
+    }
+}
+
+namespace {
+struct Run {
+    QVector<uint> codepoints;
+    bool cjk = false;
+
+    QString text(int from, int count) const
+    {
+        return QString::fromUcs4(codepoints.constData() + from, count);
+    }
+};
+}
+
+// Splits @p text into words and runs of CJK characters, everything else separates them
+static QVector<Run> segment(const QString &text)
+{
+    QVector<Run> ret;
+    Run current;
+    const auto codepoints = text.normalized(QString::NormalizationForm_KC).toCaseFolded().toUcs4();
+    for (uint c : codepoints) {
+        const bool cjk = isCjk(c);
+        if (!cjk && !QChar::isLetterOrNumber(c) && !QChar::isMark(c)) {
+            if (!current.codepoints.isEmpty())
+                ret += current;
+            current = {};
+            continue;
+        }
+
+        if (!current.codepoints.isEmpty() && current.cjk != cjk) {
+            ret += current;
+            current = {};
+        }
+        current.cjk = cjk;
+        current.codepoints += c;
+    }
+    if (!current.codepoints.isEmpty())
+        ret += current;
+    return ret;
+}
+
+namespace {
+struct QueryTerm {
+    QString text;
+    bool partial;
+};
+}
+
+// Words may be just part of the indexed ones, as in "office" for "LibreOffice".
+// CJK text is looked up in pairs of characters, which are all indexed, unless there's just one
+static QVector<QueryTerm> queryTerms(const QString &query)
+{
+    QVector<QueryTerm> ret;
+    const auto runs = segment(query);
+    for (const auto &run : runs) {
+        const int count = run.codepoints.size();
+        if (!run.cjk) {
+            ret += QueryTerm { run.text(0, count), true };
+        } else if (count == 1) {
+            ret += QueryTerm { run.text(0, 1), false };
+        } else {
+            for (int i = 0; i + 1 < count; ++i)
+                ret += QueryTerm { run.text(i, 2), false };
+        }
+    }
+    return ret;
+}
+
+// @returns how much @p indexed counts for a partial @p term found at @p position
+static double partialWeight(const QString &indexed, const QString &term, int position)
+{
+    return position > 0 ? s_infixWeight : indexed.size() == term.size() ? 1 : s_prefixWeight;
+}
+
+QStringList SearchIndex::tokenize(const QString &text)
+{
+    QStringList ret;
+    const auto runs = segment(text);
+    for (const auto &run : runs) {
+        const int count = run.codepoints.size();
+        if (!run.cjk) {
+            ret += run.text(0, count);
+            continue;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            ret += run.text(i, 1);
+            if (i + 1 < count)
+                ret += run.text(i, 2);
+        }
+    }
+    return ret;
+}
+
+SearchIndex::SearchIndex(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void SearchIndex::insert(AbstractResource* resource, const Document &document)
+{
+    remove(resource);
+
+    QHash<QString, float> frequencies;
+    float length = 0;
+    const auto addField = [&frequencies, &length] (const QString &text, float weight) {
+        const auto terms = tokenize(text);
+        for (const auto &term : terms)
+            frequencies[term] += weight;
+        length += weight * terms.size();
+    };
+    addField(document.id, s_idWeight);
+    addField(document.name, s_nameWeight);
+    addField(document.summary, s_summaryWeight);
+    for (const auto &keyword : document.keywords)
+        addField(keyword, s_keywordsWeight);
+    for (const auto &category : document.categories)
+        addField(category, s_categoriesWeight);
+
+    int slot;
+    if (m_freeSlots.isEmpty()) {
+        slot = m_entries.size();
+        m_entries.resize(slot + 1);
+    } else {
+        slot = m_freeSlots.takeLast();
+    }
+
+    Entry &entry = m_entries[slot];
+    entry.resource = resource;
+    entry.id = document.id.toCaseFolded();
+    entry.length = length;
+    entry.terms = frequencies.keys();
+    for (auto it = frequencies.constBegin(), end = frequencies.constEnd(); it != end; ++it)
+        m_postings[it.key()].insert(slot, it.value());
+    if (!entry.id.isEmpty())
+        m_ids[entry.id] += slot;
+
+    m_slots.insert(resource, slot);
+    m_totalLength += length;
+    connect(resource, &QObject::destroyed, this, &SearchIndex::resourceDestroyed, Qt::UniqueConnection);
+}
+
+void SearchIndex::remove(AbstractResource* resource)
+{
+    const auto it = m_slots.find(resource);
+    if (it == m_slots.end())
+        return;
+
+    const int slot = *it;
+    m_slots.erase(it);
+
+    Entry &entry = m_entries[slot];
+    for (const auto &term : qAsConst(entry.terms)) {
+        auto postings = m_postings.find(term);
+        if (postings != m_postings.end() && postings->remove(slot) && postings->isEmpty())
+            m_postings.erase(postings);
+    }
+    auto ids = m_ids.find(entry.id);
+    if (ids != m_ids.end() && ids->removeOne(slot) && ids->isEmpty())
+        m_ids.erase(ids);
+
+    m_totalLength -= entry.length;
+    entry = {};
+    m_freeSlots += slot;
+    disconnect(resource, &QObject::destroyed, this, &SearchIndex::resourceDestroyed);
+}
+
+void SearchIndex::resourceDestroyed(QObject* object)
+{
+    // Only used as a key, it's not dereferenced
+    remove(static_cast<AbstractResource*>(object));
+}
+
+double SearchIndex::termScore(float frequency, float length, int documentFrequency) const
+{
+    const int count = m_slots.size();
+    const double averageLength = m_totalLength / count;
+    const double relativeLength = averageLength > 0 ? length / averageLength : 1;
+    const double idf = std::log(1 + (count - documentFrequency + 0.5) / (documentFrequency + 0.5));
+    return idf * frequency * (s_k1 + 1) / (frequency + s_k1 * (1 - s_b + s_b * relativeLength));
+}
+
+QVector<AbstractResource*> SearchIndex::search(const QString &query, const QSet<AbstractResourcesBackend*> &backends) const
+{
+    const auto terms = queryTerms(query);
+    QHash<int, double> scores;
+    for (int i = 0; i < terms.size(); ++i) {
+        const QueryTerm &term = terms.at(i);
+        QHash<int, double> termScores;
+        const auto addPostings = [this, &termScores] (const QHash<int, float> &postings, double weight) {
+            const int documentFrequency = postings.size();
+            for (auto posting = postings.constBegin(), postingsEnd = postings.constEnd(); posting != postingsEnd; ++posting) {
+                const double score = weight * termScore(posting.value(), m_entries.at(posting.key()).length, documentFrequency);
+                double &current = termScores[posting.key()];
+                current = std::max(current, score);
+            }
+        };
+
+        if (!term.partial) {
+            const auto it = m_postings.constFind(term.text);
+            if (it != m_postings.constEnd())
+                addPostings(*it, 1);
+        } else {
+            // Substrings can't be looked up as a range, go through every term
+            for (auto it = m_postings.constBegin(), end = m_postings.constEnd(); it != end; ++it) {
+                const int position = it.key().indexOf(term.text);
+                if (position < 0)
+                    continue;
+                addPostings(*it, partialWeight(it.key(), term.text, position));
+            }
+        }
+
+        if (i == 0) {
+            scores = termScores;
+        } else {
+            for (auto it = scores.begin(); it != scores.end();) {
+                const auto found = termScores.constFind(it.key());
+                if (found == termScores.constEnd()) {
+                    it = scores.erase(it);
+                } else {
+                    *it += *found;
+                    ++it;
+                }
+            }
+        }
+
+        if (scores.isEmpty())
+            break;
+    }
+
+    const auto byId = m_ids.value(query.trimmed().toCaseFolded());
+    for (int slot : byId)
+        scores[slot] += s_idBonus;
+
+    QVector<QPair<double, int>> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.constBegin(), end = scores.constEnd(); it != end; ++it) {
+        if (backends.isEmpty() || backends.contains(m_entries.at(it.key()).resource->backend()))
+            ranked += qMakePair(it.value(), it.key());
+    }
+    std::sort(ranked.begin(), ranked.end(), [] (const QPair<double, int> &a, const QPair<double, int> &b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+
+    QVector<AbstractResource*> ret;
+    ret.reserve(ranked.size());
+    for (const auto &match : qAsConst(ranked))
+        ret += m_entries.at(match.second).resource;
+    return ret;
+}
+
+double SearchIndex::score(AbstractResource* resource, const QString &query) const
+{
+    const auto slot = m_slots.constFind(resource);
+    if (slot == m_slots.constEnd())
+        return 0;
+
+    // Same as search() but only going through the terms of this document
+    const Entry &entry = m_entries.at(*slot);
+    const auto terms = queryTerms(query);
+    double ret = 0;
+    bool matches = !terms.isEmpty();
+    for (const auto &term : terms) {
+        double termBest = -1;
+        const auto addTerm = [this, &entry, &slot, &termBest] (const QString &indexed, double weight) {
+            // Every term of an entry has its postings
+            const auto &postings = *m_postings.constFind(indexed);
+            termBest = std::max(termBest, weight * termScore(postings.value(*slot), entry.length, postings.size()));
+        };
+
+        if (!term.partial) {
+            if (entry.terms.contains(term.text))
+                addTerm(term.text, 1);
+        } else {
+            for (const auto &indexed : entry.terms) {
+                const int position = indexed.indexOf(term.text);
+                if (position >= 0)
+                    addTerm(indexed, partialWeight(indexed, term.text, position));
+            }
+        }
+
+        if (termBest < 0) {
+            matches = false;
+            break;
+        }
+        ret += termBest;
+    }
+
+    if (!matches)
+        ret = 0;
+    if (!entry.id.isEmpty() && entry.id == query.trimmed().toCaseFolded())
+        ret += s_idBonus;
+    return ret;
+}
+
+QVector<AbstractResource*> SearchIndex::findById(const QString &id) const
+{
+    QVector<AbstractResource*> ret;
+    const auto matches = m_ids.value(id.toCaseFolded());
+    for (int slot : matches)
+        ret += m_entries.at(slot).resource;
+    return ret;
+}
@@ -0,0 +1,89 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include "discovercommon_export.h"
+
+class AbstractResource;
+class AbstractResourcesBackend;
+
+/**
+ * Full-text index backends can use to rank the resources they find.
+ *
+ * Text is case folded and split into words. Runs of CJK characters, which aren't
+ * separated by spaces, are indexed as single characters and as overlapping pairs
+ * of characters so that Chinese queries match regardless of where words start.
+ *
+ * Matches are ranked with BM25, giving more weight to the name and the keywords
+ * than to the summary. Every word in the query has to be found, though it can
+ * be just part of an indexed word, ranking lower the less of it it is.
+ */
+class DISCOVERCOMMON_EXPORT SearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    struct Document {
+        QString id;
+        QString name;
+        QString summary;
+        QStringList keywords;
+        QStringList categories;
+    };
+
+    explicit SearchIndex(QObject* parent = nullptr);
+
+    /// Adds @p resource to the index, replacing the document it had if it was already there
+    void insert(AbstractResource* resource, const Document &document);
+    void remove(AbstractResource* resource);
+    bool contains(AbstractResource* resource) const { return m_slots.contains(resource); }
+    int size() const { return m_slots.size(); }
+
+    /// @returns the resources matching @p query sorted by relevance, only from @p backends unless it's empty
+    QVector<AbstractResource*> search(const QString &query, const QSet<AbstractResourcesBackend*> &backends = {}) const;
+
+    /**
+     * @returns how relevant @p resource is for @p query, 0 if it doesn't match
+     *
+     * Ranks like search() does, but only looks at the terms of @p resource, which
+     * makes it cheap to sort the few results a backend found some other way.
+     */
+    double score(AbstractResource* resource, const QString &query) const;
+
+    /// @returns the resources registered with @p id, compared case insensitively
+    QVector<AbstractResource*> findById(const QString &id) const;
+
+    /// @returns the terms @p text is indexed as
+    static QStringList tokenize(const QString &text);
+
+private Q_SLOTS:
+    void resourceDestroyed(QObject* object);
+
+private:
+    struct Entry {
+        AbstractResource* resource = nullptr;
+        QString id;
+        float length = 0;
+        QStringList terms;
+    };
+
+    double termScore(float frequency, float length, int documentFrequency) const;
+
+    QVector<Entry> m_entries;
+    QVector<int> m_freeSlots;
+    QHash<AbstractResource*, int> m_slots;
+    QHash<QString, QVector<int>> m_ids;
+    QHash<QString, QHash<int, float>> m_postings;
+    double m_totalLength = 0;
+};
+
+#endif // SEARCHINDEX_H
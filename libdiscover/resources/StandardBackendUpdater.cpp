@@ -8,20 +8,28 @@
 #include <resources/AbstractResourcesBackend.h>
 #include <resources/AbstractResource.h>
 #include "ResourcesModel.h"
+#include "ProgressAggregator.h"
 #include <Transaction/Transaction.h>
 #include <Transaction/TransactionModel.h>
 #include <KLocalizedString>
+#include <KConfigGroup>
+#include <KSharedConfig>
 #include "libdiscover_debug.h"
 #include "utils.h"
 #include <QIcon>
+#include <algorithm>
 
 StandardBackendUpdater::StandardBackendUpdater(AbstractResourcesBackend* parent)
     : AbstractBackendUpdater(parent)
     , m_backend(parent)
+    , m_transactionsProgress(new ProgressAggregator(this))
     , m_settingUp(false)
     , m_progress(0)
     , m_lastUpdate(QDateTime())
 {
+    KConfigGroup group(KSharedConfig::openConfig(), "Software");
+    m_maxParallel = qMax(1, group.readEntry<int>("ParallelUpdates", 3));
+
     connect(m_backend, &AbstractResourcesBackend::fetchingChanged, this, &StandardBackendUpdater::refreshUpdateable);
     connect(m_backend, &AbstractResourcesBackend::resourcesChanged, this, &StandardBackendUpdater::resourcesChanged);
     connect(m_backend, &AbstractResourcesBackend::resourceRemoved, this, [this](AbstractResource* resource) {
@@ -30,6 +38,8 @@ StandardBackendUpdater::StandardBackendUpdater(AbstractResourcesBackend* parent)
     });
     connect(TransactionModel::global(), &TransactionModel::transactionRemoved, this, &StandardBackendUpdater::transactionRemoved);
     connect(TransactionModel::global(), &TransactionModel::transactionAdded, this, &StandardBackendUpdater::transactionAdded);
+    connect(m_transactionsProgress, &ProgressAggregator::sourceProgressed, this, &StandardBackendUpdater::transactionProgressed);
+    connect(m_transactionsProgress, &ProgressAggregator::progressChanged, this, &StandardBackendUpdater::refreshProgress);
 
     m_timer.setSingleShot(true);
     m_timer.setInterval(10);
@@ -52,26 +62,26 @@ void StandardBackendUpdater::start()
     m_settingUp = true;
     emit progressingChanged(true);
     setProgress(0);
-    auto upgradeList = m_toUpgrade.values();
-    std::sort(upgradeList.begin(), upgradeList.end(), [](const AbstractResource* a, const AbstractResource* b) {
-        return a->name() < b->name();
-    });
 
-    const bool couldCancel = m_canCancel;
-    foreach (AbstractResource* res, upgradeList) {
-        m_pendingResources += res;
-        auto t = m_backend->installApplication(res);
-        t->setVisible(false);
-        t->setProperty("updater", QVariant::fromValue<QObject*>(this));
-        connect(t, &Transaction::downloadSpeedChanged, this, [this]() {
-            Q_EMIT downloadSpeedChanged(downloadSpeed());
-        });
-        connect(this, &StandardBackendUpdater::cancelTransaction, t, &Transaction::cancel);
-        TransactionModel::global()->addTransaction(t);
-        m_canCancel |= t->isCancellable();
-    }
-    if (m_canCancel != couldCancel) {
-        Q_EMIT cancelableChanged(m_canCancel);
+    // Runtimes and libraries go first so applications are updated against them
+    m_queue = kSetToVector(m_toUpgrade);
+    std::sort(m_queue.begin(), m_queue.end(), [](const AbstractResource* a, const AbstractResource* b) {
+        const bool technicalA = a->type() == AbstractResource::Technical, technicalB = b->type() == AbstractResource::Technical;
+        return technicalA != technicalB ? technicalA : a->name() < b->name();
+    });
+    m_pendingResources = m_toUpgrade;
+
+    if (m_batchUpdates) {
+        const auto transactions = m_backend->installApplications(m_queue);
+        m_queue.clear();
+        QSet<AbstractResource*> started;
+        for (auto t : transactions) {
+            started += t->resource();
+            addUpdateTransaction(t);
+        }
+        m_pendingResources &= started;
+    } else {
+        startNextUpdates();
     }
     m_settingUp = false;
 
@@ -82,9 +92,98 @@ void StandardBackendUpdater::start()
     }
 }
 
+int StandardBackendUpdater::maxParallelUpdates() const
+{
+    return m_maxParallel;
+}
+
+void StandardBackendUpdater::setMaxParallelUpdates(int max)
+{
+    m_maxParallel = qMax(1, max);
+    startNextUpdates();
+}
+
+void StandardBackendUpdater::setBatchUpdates(bool batch)
+{
+    m_batchUpdates = batch;
+}
+
+bool StandardBackendUpdater::hasPendingTechnical() const
+{
+    return std::any_of(m_pendingResources.constBegin(), m_pendingResources.constEnd(), [](AbstractResource* res) {
+        return res->type() == AbstractResource::Technical;
+    });
+}
+
+void StandardBackendUpdater::startNextUpdates()
+{
+    while (!m_queue.isEmpty() && m_running.size() < m_maxParallel) {
+        AbstractResource* res = m_queue.constFirst();
+        if (res->type() != AbstractResource::Technical && hasPendingTechnical()) {
+            break;
+        }
+
+        m_queue.removeFirst();
+        startUpdate(res);
+    }
+}
+
+void StandardBackendUpdater::startUpdate(AbstractResource* res)
+{
+    auto t = m_backend->installApplication(res);
+    if (!t) {
+        qCWarning(LIBDISCOVER_LOG) << "could not update" << res->name();
+        m_pendingResources.remove(res);
+        return;
+    }
+
+    m_running.insert(t);
+    addUpdateTransaction(t);
+}
+
+void StandardBackendUpdater::addUpdateTransaction(Transaction* t)
+{
+    t->setVisible(false);
+    t->setProperty("updater", QVariant::fromValue<QObject*>(this));
+    connect(t, &Transaction::downloadSpeedChanged, this, [this]() {
+        Q_EMIT downloadSpeedChanged(downloadSpeed());
+    });
+    connect(t, &Transaction::statusChanged, this, [this, t]() {
+        transactionStatusChanged(t);
+    });
+    connect(this, &StandardBackendUpdater::cancelTransaction, t, &Transaction::cancel);
+    m_transactions.insert(t);
+    TransactionModel::global()->addTransaction(t);
+
+    if (!m_canCancel && t->isCancellable()) {
+        m_canCancel = true;
+        Q_EMIT cancelableChanged(m_canCancel);
+    }
+}
+
+void StandardBackendUpdater::transactionStatusChanged(Transaction* t)
+{
+    // Once an update is installing, the next one can start downloading. Backends that go
+    // straight to CommittingStatus download as they install, so they keep their slot
+    if (t->status() == Transaction::DownloadingStatus) {
+        m_downloaded.insert(t);
+    } else if (t->status() >= Transaction::CommittingStatus && m_downloaded.contains(t) && m_running.remove(t)) {
+        startNextUpdates();
+    }
+}
+
 void StandardBackendUpdater::cancel()
 {
+    // What didn't start yet is just dropped
+    for (auto res : qAsConst(m_queue)) {
+        m_pendingResources.remove(res);
+    }
+    m_queue.clear();
     Q_EMIT cancelTransaction();
+
+    if (m_pendingResources.isEmpty() && !m_settingUp && m_transactions.isEmpty()) {
+        cleanup();
+    }
 }
 
 void StandardBackendUpdater::transactionAdded(Transaction* newTransaction)
@@ -92,8 +191,12 @@ void StandardBackendUpdater::transactionAdded(Transaction* newTransaction)
     if (!m_pendingResources.contains(newTransaction->resource()))
         return;
 
-    connect(newTransaction, &Transaction::progressChanged, this, &StandardBackendUpdater::transactionProgressChanged);
-    connect(newTransaction, &Transaction::statusChanged, this, &StandardBackendUpdater::transactionProgressChanged);
+    // Status changes are reported too, they change the state of the resource
+    const auto progressed = [this, newTransaction] {
+        m_transactionsProgress->setProgress(newTransaction, newTransaction->progress());
+    };
+    connect(newTransaction, &Transaction::progressChanged, this, progressed);
+    connect(newTransaction, &Transaction::statusChanged, this, progressed);
 }
 
 AbstractBackendUpdater::State toUpdateState(Transaction* t)
@@ -114,12 +217,10 @@ AbstractBackendUpdater::State toUpdateState(Transaction* t)
     Q_UNREACHABLE();
 }
 
-void StandardBackendUpdater::transactionProgressChanged()
+void StandardBackendUpdater::transactionProgressed(QObject* transaction, qreal progress)
 {
-    Transaction* t = qobject_cast<Transaction*>(sender());
-    Q_EMIT resourceProgressed(t->resource(), t->progress(), toUpdateState(t));
-
-    refreshProgress();
+    Transaction* t = static_cast<Transaction*>(transaction);
+    Q_EMIT resourceProgressed(t->resource(), progress, toUpdateState(t));
 }
 
 void StandardBackendUpdater::transactionRemoved(Transaction* t)
@@ -130,6 +231,16 @@ void StandardBackendUpdater::transactionRemoved(Transaction* t)
     }
 
     const bool found = fromOurBackend && m_pendingResources.remove(t->resource());
+    m_transactions.remove(t);
+    m_running.remove(t);
+    m_downloaded.remove(t);
+    // It's counted as done from now on. The transaction is removed as soon as it's done,
+    // before the aggregator reports it, so the final state is let known right away
+    if (m_transactionsProgress->contains(t)) {
+        m_transactionsProgress->remove(t);
+        Q_EMIT resourceProgressed(t->resource(), t->progress(), toUpdateState(t));
+    }
+    startNextUpdates();
 
     if (found && !m_settingUp) {
         refreshProgress();
@@ -146,12 +257,8 @@ void StandardBackendUpdater::refreshProgress()
         return;
     }
 
-    int allProgresses = (m_toUpgrade.size() - m_pendingResources.size()) * 100;
-    const auto allTransactions = transactions();
-    for (auto t: allTransactions) {
-        allProgresses += t->progress();
-    }
-    setProgress(allProgresses / m_toUpgrade.size());
+    const qreal allProgresses = (m_toUpgrade.size() - m_pendingResources.size()) * 100 + m_transactionsProgress->total();
+    setProgress(int(allProgresses) / m_toUpgrade.size());
 }
 
 void StandardBackendUpdater::refreshUpdateable()
@@ -226,6 +333,7 @@ void StandardBackendUpdater::cleanup()
 {
     m_lastUpdate = QDateTime::currentDateTime();
     m_toUpgrade.clear();
+    m_transactionsProgress->clear();
 
     refreshUpdateable();
     emit progressingChanged(false);
@@ -265,19 +373,11 @@ double StandardBackendUpdater::updateSize() const
     return ret;
 }
 
-QVector<Transaction *> StandardBackendUpdater::transactions() const
-{
-    const auto trans = TransactionModel::global()->transactions();
-    return kFilter<QVector<Transaction*>>(trans, [this](Transaction* t) {
-        return t->property("updater").value<QObject*>() == this;
-    });
-}
-
 quint64 StandardBackendUpdater::downloadSpeed() const
 {
+    // All the updates running at once share the connection, so their speeds add up
     quint64 ret = 0;
-    const auto trans = transactions();
-    for (Transaction* t: trans) {
+    for (Transaction* t: qAsConst(m_transactions)) {
         ret += t->downloadSpeed();
     }
     return ret;
@@ -15,6 +15,7 @@
 #include <QTimer>
 
 class AbstractResourcesBackend;
+class ProgressAggregator;
 
 class DISCOVERCOMMON_EXPORT StandardBackendUpdater : public AbstractBackendUpdater
 {
@@ -42,6 +43,21 @@ public:
     quint64 downloadSpeed() const override;
     Transaction* updateResource(AbstractResource* app) override;
 
+    /**
+     * How many updates can be running at the same time, read from the Software/ParallelUpdates setting
+     *
+     * Updates that report DownloadingStatus free their slot once they start installing,
+     * the others keep it until they are done.
+     */
+    int maxParallelUpdates() const;
+    void setMaxParallelUpdates(int max);
+
+    /**
+     * Hands all the updates to AbstractResourcesBackend::installApplications() at once,
+     * for backends that schedule them better by themselves
+     */
+    void setBatchUpdates(bool batch);
+
 Q_SIGNALS:
     void cancelTransaction();
     void updatesCountChanged(int updatesCount);
@@ -54,14 +70,27 @@ private:
     void resourcesChanged(AbstractResource* res, const QVector<QByteArray>& props);
     void refreshUpdateable();
     void transactionAdded(Transaction* newTransaction);
-    void transactionProgressChanged();
+    void transactionProgressed(QObject* transaction, qreal progress);
     void refreshProgress();
-    QVector<Transaction*> transactions() const;
+    void startNextUpdates();
+    void startUpdate(AbstractResource* res);
+    void addUpdateTransaction(Transaction* t);
+    void transactionStatusChanged(Transaction* t);
+    bool hasPendingTechnical() const;
 
     QSet<AbstractResource*> m_toUpgrade;
     QSet<AbstractResource*> m_upgradeable;
     AbstractResourcesBackend * const m_backend;
     QSet<AbstractResource*> m_pendingResources;
+    // Updates that haven't been started yet, in the order they will be
+    QVector<AbstractResource*> m_queue;
+    QSet<Transaction*> m_transactions;
+    // Transactions limited by m_maxParallel: until they install if they reported downloading, until they finish otherwise
+    QSet<Transaction*> m_running;
+    QSet<Transaction*> m_downloaded;
+    ProgressAggregator* const m_transactionsProgress;
+    int m_maxParallel;
+    bool m_batchUpdates = false;
     bool m_settingUp;
     qreal m_progress;
     QDateTime m_lastUpdate;
@@ -0,0 +1,161 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "UpdatesChecker.h"
+#include "AbstractResourcesBackend.h"
+#include "AbstractBackendUpdater.h"
+#include "libdiscover_debug.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <QStringList>
+#include <QTimer>
+
+static bool isBusy(AbstractResourcesBackend* backend)
+{
+    return backend->isFetching() || (backend->backendUpdater() && backend->backendUpdater()->isProgressing());
+}
+
+UpdatesChecker::UpdatesChecker(QObject* parent)
+    : QObject(parent)
+    , m_deadline(new QTimer(this))
+{
+    KConfigGroup group(KSharedConfig::openConfig(), "Software");
+    m_deadline->setInterval(qMax(1, group.readEntry<int>("UpdatesCheckTimeout", 120)) * 1000);
+    m_deadline->setSingleShot(true);
+    connect(m_deadline, &QTimer::timeout, this, &UpdatesChecker::deadlineReached);
+}
+
+int UpdatesChecker::deadline() const
+{
+    return m_deadline->interval();
+}
+
+void UpdatesChecker::setDeadline(int msecs)
+{
+    m_deadline->setInterval(msecs);
+}
+
+bool UpdatesChecker::isChecking() const
+{
+    return m_deadline->isActive();
+}
+
+bool UpdatesChecker::isLate(AbstractResourcesBackend* backend) const
+{
+    return !isChecking() && m_pending.contains(backend);
+}
+
+int UpdatesChecker::updatesCount() const
+{
+    return m_updatesCount;
+}
+
+QHash<AbstractResourcesBackend*, UpdatesChecker::Result> UpdatesChecker::results() const
+{
+    return m_results;
+}
+
+void UpdatesChecker::start(const QVector<AbstractResourcesBackend*> &backends)
+{
+    if (isChecking()) {
+        QStringList names;
+        for (auto it = m_pending.constBegin(), end = m_pending.constEnd(); it != end; ++it)
+            names += it.key()->name();
+        qCInfo(LIBDISCOVER_LOG) << "not checking for updates again, still waiting for" << names;
+        return;
+    }
+
+    m_results.clear();
+    m_updatesCount = 0;
+    m_deadline->start();
+    Q_EMIT checkingChanged();
+    Q_EMIT updatesCountChanged(m_updatesCount);
+
+    // Backends only start the check here, none of them waits for the others
+    for (auto backend : backends) {
+        m_results.insert(backend, {});
+        if (m_pending.contains(backend)) {
+            qCInfo(LIBDISCOVER_LOG) << "still checking for updates since the previous deadline, will ask again once done" << backend->name();
+            m_recheck.insert(backend);
+            continue;
+        }
+
+        startBackend(backend);
+    }
+
+    if (m_pending.isEmpty())
+        finish(false);
+}
+
+void UpdatesChecker::startBackend(AbstractResourcesBackend* backend)
+{
+    m_pending[backend].start();
+    connect(backend, &AbstractResourcesBackend::fetchingChanged, this, [this, backend] { checkBackend(backend); });
+    if (backend->backendUpdater()) {
+        connect(backend->backendUpdater(), &AbstractBackendUpdater::progressingChanged, this, [this, backend] { checkBackend(backend); });
+    }
+    connect(backend, &QObject::destroyed, this, [this, backend] {
+        m_pending.remove(backend);
+        m_results.remove(backend);
+        m_recheck.remove(backend);
+        if (m_pending.isEmpty() && isChecking())
+            finish(false);
+    });
+    backend->checkForUpdates();
+
+    // Backends that had nothing to do won't tell us
+    QTimer::singleShot(0, this, [this, backend] { checkBackend(backend); });
+}
+
+void UpdatesChecker::checkBackend(AbstractResourcesBackend* backend)
+{
+    if (m_pending.contains(backend) && !isBusy(backend))
+        backendDone(backend);
+}
+
+void UpdatesChecker::backendDone(AbstractResourcesBackend* backend)
+{
+    const qint64 duration = m_pending.take(backend).elapsed();
+    disconnect(backend, nullptr, this, nullptr);
+    if (backend->backendUpdater())
+        disconnect(backend->backendUpdater(), nullptr, this, nullptr);
+
+    // What it found is from before the check that is running now
+    if (m_recheck.remove(backend) && isChecking()) {
+        qCDebug(LIBDISCOVER_LOG) << "asking again for updates" << backend->name() << "after" << duration << "ms";
+        startBackend(backend);
+        return;
+    }
+
+    Result &result = m_results[backend];
+    result.updatesCount = backend->updatesCount();
+    result.duration = duration;
+    qCDebug(LIBDISCOVER_LOG) << "checked for updates" << backend->name() << result.updatesCount << "updates in" << duration << "ms";
+
+    m_updatesCount += result.updatesCount;
+    Q_EMIT backendChecked(backend, result.updatesCount, duration);
+    Q_EMIT updatesCountChanged(m_updatesCount);
+
+    if (m_pending.isEmpty() && isChecking())
+        finish(false);
+}
+
+void UpdatesChecker::deadlineReached()
+{
+    for (auto it = m_pending.constBegin(), end = m_pending.constEnd(); it != end; ++it) {
+        qCWarning(LIBDISCOVER_LOG) << "checking for updates took too long" << it.key()->name() << it->elapsed() << "ms";
+        m_results[it.key()].timedOut = true;
+    }
+    finish(true);
+}
+
+void UpdatesChecker::finish(bool timedOut)
+{
+    m_deadline->stop();
+    Q_EMIT checkingChanged();
+    Q_EMIT finished(timedOut);
+}
@@ -0,0 +1,79 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#ifndef UPDATESCHECKER_H
+#define UPDATESCHECKER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "discovercommon_export.h"
+
+class QTimer;
+class AbstractResourcesBackend;
+
+/**
+ * Asks all the backends to check for updates at the same time and follows
+ * them until they are done.
+ *
+ * The updates found are published as every backend finishes, the check is
+ * considered over once they all did or the deadline is reached, whichever
+ * comes first. Backends that are late still report their results when they
+ * get to it, and are asked again if another check started meanwhile.
+ */
+class DISCOVERCOMMON_EXPORT UpdatesChecker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool isChecking READ isChecking NOTIFY checkingChanged)
+    Q_PROPERTY(int updatesCount READ updatesCount NOTIFY updatesCountChanged)
+public:
+    struct Result {
+        int updatesCount = 0;
+        /// In milliseconds, -1 while it's still checking
+        qint64 duration = -1;
+        bool timedOut = false;
+    };
+
+    explicit UpdatesChecker(QObject* parent = nullptr);
+
+    /// How long the check waits for the backends, in milliseconds, read from the Software/UpdatesCheckTimeout setting in seconds
+    int deadline() const;
+    void setDeadline(int msecs);
+
+    void start(const QVector<AbstractResourcesBackend*> &backends);
+    bool isChecking() const;
+    /// @returns whether @p backend is still checking even though the deadline passed
+    bool isLate(AbstractResourcesBackend* backend) const;
+
+    /// @returns the updates found by the backends that finished checking
+    int updatesCount() const;
+    QHash<AbstractResourcesBackend*, Result> results() const;
+
+Q_SIGNALS:
+    void checkingChanged();
+    void updatesCountChanged(int updatesCount);
+    void backendChecked(AbstractResourcesBackend* backend, int updatesCount, qint64 duration);
+    /// Emitted when the check is over, @p timedOut tells whether some backends didn't make it
+    void finished(bool timedOut);
+
+private:
+    void startBackend(AbstractResourcesBackend* backend);
+    void checkBackend(AbstractResourcesBackend* backend);
+    void backendDone(AbstractResourcesBackend* backend);
+    void deadlineReached();
+    void finish(bool timedOut);
+
+    QHash<AbstractResourcesBackend*, QElapsedTimer> m_pending;
+    QHash<AbstractResourcesBackend*, Result> m_results;
+    // Late backends that a newer check couldn't ask yet
+    QSet<AbstractResourcesBackend*> m_recheck;
+    QTimer* const m_deadline;
+    int m_updatesCount = 0;
+};
+
+#endif // UPDATESCHECKER_H
@@ -0,0 +1,194 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <QtTest>
+#include <QJsonArray>
+#include <resources/AbstractResource.h>
+#include <resources/SearchIndex.h>
+
+// Only its address matters to the index
+class TestResource : public AbstractResource
+{
+public:
+    TestResource() : AbstractResource(nullptr) {}
+
+    QString packageName() const override { return {}; }
+    QString name() const override { return {}; }
+    QString comment() override { return {}; }
+    QVariant icon() const override { return {}; }
+    bool canExecute() const override { return false; }
+    void invokeApplication() const override {}
+    State state() override { return None; }
+    QStringList categories() override { return {}; }
+    Type type() const override { return Application; }
+    int size() override { return 0; }
+    QJsonArray licenses() override { return {}; }
+    QString installedVersion() const override { return {}; }
+    QString availableVersion() const override { return {}; }
+    QString longDescription() override { return {}; }
+    QString origin() const override { return {}; }
+    QString section() override { return {}; }
+    QString author() const override { return {}; }
+    QList<PackageState> addonsInformation() override { return {}; }
+    QString sourceIcon() const override { return {}; }
+    QDate releaseDate() const override { return {}; }
+    void fetchChangelog() override {}
+};
+
+class SearchIndexTest : public QObject
+{
+    Q_OBJECT
+private:
+    AbstractResource* add(SearchIndex &index, const SearchIndex::Document &document)
+    {
+        auto resource = new TestResource;
+        m_resources.append(resource);
+        index.insert(resource, document);
+        return resource;
+    }
+
+    QVector<AbstractResource*> m_resources;
+
+private Q_SLOTS:
+    void cleanup()
+    {
+        qDeleteAll(m_resources);
+        m_resources.clear();
+    }
+
+    void testTokenize_data()
+    {
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<QStringList>("tokens");
+
+        QTest::newRow("words") << QStringLiteral("LibreOffice Writer") << QStringList { QStringLiteral("libreoffice"), QStringLiteral("writer") };
+        QTest::newRow("punctuation") << QStringLiteral("org.kde.Krita, 5!") << QStringList { QStringLiteral("org"), QStringLiteral("kde"), QStringLiteral("krita"), QStringLiteral("5") };
+        QTest::newRow("fullwidth") << QStringLiteral("ＫＤＥ") << QStringList { QStringLiteral("kde") };
+        QTest::newRow("cjk") << QStringLiteral("文本编辑") << QStringList { QStringLiteral("文"), QStringLiteral("文本"), QStringLiteral("本"), QStringLiteral("本编"),
+                                                                        QStringLiteral("编"), QStringLiteral("编辑"), QStringLiteral("辑") };
+        QTest::newRow("mixed") << QStringLiteral("Qt中文") << QStringList { QStringLiteral("qt"), QStringLiteral("中"), QStringLiteral("中文"), QStringLiteral("文") };
+        QTest::newRow("empty") << QStringLiteral(" - ") << QStringList {};
+    }
+
+    void testTokenize()
+    {
+        QFETCH(QString, text);
+        QFETCH(QStringList, tokens);
+        QCOMPARE(SearchIndex::tokenize(text), tokens);
+    }
+
+    void testSubstring()
+    {
+        SearchIndex index;
+        auto office = add(index, { QStringLiteral("org.libreoffice.LibreOffice"), QStringLiteral("LibreOffice"), QStringLiteral("Productivity suite"), {}, {} });
+        add(index, { QStringLiteral("org.kde.krita"), QStringLiteral("Krita"), QStringLiteral("Digital painting"), {}, {} });
+
+        QCOMPARE(index.search(QStringLiteral("office")), QVector<AbstractResource*> { office });
+        QCOMPARE(index.search(QStringLiteral("OFFICE")), QVector<AbstractResource*> { office });
+        QCOMPARE(index.search(QStringLiteral("ductiv")), QVector<AbstractResource*> { office });
+        QVERIFY(index.search(QStringLiteral("spreadsheet")).isEmpty());
+    }
+
+    void testPartialRanking()
+    {
+        SearchIndex index;
+        auto infix = add(index, { QStringLiteral("c"), QStringLiteral("LibreOffice"), QStringLiteral("Application"), {}, {} });
+        auto prefix = add(index, { QStringLiteral("b"), QStringLiteral("Officer"), QStringLiteral("Application"), {}, {} });
+        auto exact = add(index, { QStringLiteral("a"), QStringLiteral("Office"), QStringLiteral("Application"), {}, {} });
+
+        const QVector<AbstractResource*> expected = { exact, prefix, infix };
+        QCOMPARE(index.search(QStringLiteral("office")), expected);
+    }
+
+    void testFieldWeights()
+    {
+        SearchIndex index;
+        auto inSummary = add(index, { QStringLiteral("b"), QStringLiteral("Notes"), QStringLiteral("Writer of text"), {}, {} });
+        auto inName = add(index, { QStringLiteral("a"), QStringLiteral("Writer"), QStringLiteral("Edit text"), {}, {} });
+        auto inKeywords = add(index, { QStringLiteral("c"), QStringLiteral("Pad"), QStringLiteral("Edit text"), { QStringLiteral("writer") }, {} });
+
+        const QVector<AbstractResource*> expected = { inName, inKeywords, inSummary };
+        QCOMPARE(index.search(QStringLiteral("writer")), expected);
+    }
+
+    void testAllWords()
+    {
+        SearchIndex index;
+        auto writer = add(index, { QStringLiteral("a"), QStringLiteral("Writer"), QStringLiteral("Edit text"), {}, {} });
+        auto notes = add(index, { QStringLiteral("b"), QStringLiteral("Notes"), QStringLiteral("Writer of text"), {}, {} });
+
+        QCOMPARE(index.search(QStringLiteral("text writer")).size(), 2);
+        QCOMPARE(index.search(QStringLiteral("writer notes")), QVector<AbstractResource*> { notes });
+        QCOMPARE(index.search(QStringLiteral("edit writ")), QVector<AbstractResource*> { writer });
+    }
+
+    void testScore()
+    {
+        SearchIndex index;
+        auto infix = add(index, { QStringLiteral("c"), QStringLiteral("LibreOffice"), QStringLiteral("Application"), {}, {} });
+        auto prefix = add(index, { QStringLiteral("b"), QStringLiteral("Officer"), QStringLiteral("Application"), {}, {} });
+        auto exact = add(index, { QStringLiteral("a"), QStringLiteral("Office"), QStringLiteral("Application"), {}, {} });
+        auto other = add(index, { QStringLiteral("d"), QStringLiteral("Krita"), QStringLiteral("Digital painting"), {}, {} });
+
+        // Scores rank like the whole index does
+        const QString query = QStringLiteral("office application");
+        const auto ranked = index.search(query);
+        QCOMPARE(ranked, (QVector<AbstractResource*> { exact, prefix, infix }));
+        QVERIFY(index.score(exact, query) > index.score(prefix, query));
+        QVERIFY(index.score(prefix, query) > index.score(infix, query));
+        QVERIFY(index.score(infix, query) > 0);
+        QCOMPARE(index.score(other, query), 0.);
+        QVERIFY(index.score(other, QStringLiteral("d")) > index.score(exact, QStringLiteral("d")));
+    }
+
+    void testId()
+    {
+        SearchIndex index;
+        add(index, { QStringLiteral("org.kde.kate"), QStringLiteral("Kate"), QStringLiteral("Notes and code, like org.kde.kwrite"), {}, {} });
+        auto kwrite = add(index, { QStringLiteral("org.kde.kwrite"), QStringLiteral("KWrite"), QStringLiteral("Text editor"), {}, {} });
+
+        QCOMPARE(index.search(QStringLiteral("org.kde.kwrite")).constFirst(), kwrite);
+        QCOMPARE(index.findById(QStringLiteral("ORG.KDE.KWRITE")), QVector<AbstractResource*> { kwrite });
+    }
+
+    void testCjk()
+    {
+        SearchIndex index;
+        auto editor = add(index, { QStringLiteral("a"), QStringLiteral("文本编辑器"), QStringLiteral("编辑文本"), {}, {} });
+        add(index, { QStringLiteral("b"), QStringLiteral("图像"), QStringLiteral("查看图片"), {}, {} });
+
+        QCOMPARE(index.search(QStringLiteral("编辑")), QVector<AbstractResource*> { editor });
+        QCOMPARE(index.search(QStringLiteral("辑器")), QVector<AbstractResource*> { editor });
+        QCOMPARE(index.search(QStringLiteral("本")), QVector<AbstractResource*> { editor });
+        QVERIFY(index.search(QStringLiteral("编图")).isEmpty());
+    }
+
+    void testRemove()
+    {
+        SearchIndex index;
+        auto kate = add(index, { QStringLiteral("org.kde.kate"), QStringLiteral("Kate"), QStringLiteral("Text editor"), {}, {} });
+        auto kwrite = add(index, { QStringLiteral("org.kde.kwrite"), QStringLiteral("KWrite"), QStringLiteral("Text editor"), {}, {} });
+        QCOMPARE(index.size(), 2);
+
+        index.remove(kate);
+        QVERIFY(!index.contains(kate));
+        QCOMPARE(index.search(QStringLiteral("editor")), QVector<AbstractResource*> { kwrite });
+        QVERIFY(index.findById(QStringLiteral("org.kde.kate")).isEmpty());
+
+        // Inserting again replaces what was indexed
+        index.insert(kwrite, { QStringLiteral("org.kde.kwrite"), QStringLiteral("KWrite"), QStringLiteral("Simple"), {}, {} });
+        QCOMPARE(index.size(), 1);
+        QVERIFY(index.search(QStringLiteral("editor")).isEmpty());
+
+        m_resources.removeAll(kwrite);
+        delete kwrite;
+        QCOMPARE(index.size(), 0);
+    }
+};
+
+QTEST_MAIN(SearchIndexTest)
+
+#include "SearchIndexTest.moc"
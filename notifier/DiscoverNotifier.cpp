@@ -7,14 +7,19 @@
 #include "DiscoverNotifier.h"
 #include "BackendNotifierFactory.h"
 #include "UnattendedUpdates.h"
+#include "UpdatesProbe.h"
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDBusConnection>
 #include <QDBusPendingCall>
 #include <QDBusMessage>
 #include <QNetworkConfigurationManager>
+#include <QProcess>
+#include <KConfigGroup>
 #include <KLocalizedString>
 #include <KNotificationJobUiDelegate>
 #include <KPluginFactory>
+#include <KSharedConfig>
 
 #include <KIO/ApplicationLauncherJob>
 #include <KIO/CommandLauncherJob>
@@ -25,12 +30,70 @@
 DiscoverNotifier::DiscoverNotifier(QObject * parent)
     : QObject(parent)
 {
+    const KConfigGroup behavior(KSharedConfig::openConfig(), "Behavior");
+    m_lightweight = behavior.readEntry<bool>("Lightweight", false);
+    m_memoryBudget = behavior.readEntry<qint64>("MemoryBudget", 0) * 1024 * 1024;
+
+    // The backends are only worth their memory once there's something to show,
+    // until then a probe waits for the metadata to change
+    const KConfigGroup state(KSharedConfig::openConfig(), "State");
+    if (!m_lightweight || state.readEntry<bool>("HasUpdates", false) || state.readEntry<bool>("NeedsReboot", false)) {
+        loadModules();
+    } else {
+        m_probe = new UpdatesProbe(this);
+        connect(m_probe, &UpdatesProbe::refreshDue, this, &DiscoverNotifier::recheckSystemUpdateNeeded);
+        connect(m_probe, &UpdatesProbe::checked, this, [this] (bool hasUpdates) {
+            if (hasUpdates)
+                recheckSystemUpdateNeeded();
+        });
+    }
+
+    // connect(&m_timer, &QTimer::timeout, this, &DiscoverNotifier::showUpdatesNotification);
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(1000);
+    updateStatusNotifier();
+
+    //Only fetch updates after the system is comfortably booted
+    QTimer::singleShot(20000, this, [this] {
+        if (m_modulesLoaded)
+            recheckSystemUpdateNeeded();
+        else if (m_probe)
+            m_probe->check();
+    });
+
+    m_settings = new UpdatesSettings(this);
+    m_settingsWatcher = KConfigWatcher::create(m_settings->sharedConfig());
+    refreshUnattended();
+    connect(m_settingsWatcher.data(), &KConfigWatcher::configChanged, this, &DiscoverNotifier::refreshUnattended);
+
+    if (m_lightweight && m_memoryBudget > 0) {
+        auto memoryTimer = new QTimer(this);
+        memoryTimer->setInterval(60 * 60 * 1000);
+        connect(memoryTimer, &QTimer::timeout, this, &DiscoverNotifier::checkMemoryBudget);
+        memoryTimer->start();
+    }
+}
+
+DiscoverNotifier::~DiscoverNotifier() = default;
+
+void DiscoverNotifier::loadModules()
+{
+    if (m_modulesLoaded)
+        return;
+
+    m_modulesLoaded = true;
+    if (m_probe) {
+        m_probe->deleteLater();
+        m_probe = nullptr;
+    }
+
     m_backends = BackendNotifierFactory().allBackends();
     foreach (BackendNotifierModule* module, m_backends) {
         connect(module, &BackendNotifierModule::foundUpdates, this, &DiscoverNotifier::updateStatusNotifier);
         connect(module, &BackendNotifierModule::needsRebootChanged, this, [this]() {
             if (!m_needsReboot) {
                 m_needsReboot = true;
+                storeState();
                 showRebootNotification();
                 Q_EMIT stateChanged();
                 Q_EMIT needsRebootChanged(true);
@@ -39,23 +102,20 @@ DiscoverNotifier::DiscoverNotifier(QObject * parent)
 
         connect(module, &BackendNotifierModule::foundUpgradeAction, this, &DiscoverNotifier::foundUpgradeAction);
     }
-    
-    // connect(&m_timer, &QTimer::timeout, this, &DiscoverNotifier::showUpdatesNotification);
-    m_timer.setSingleShot(true);
-    m_timer.setInterval(1000);
-    updateStatusNotifier();
+}
 
-    //Only fetch updates after the system is comfortably booted
-    QTimer::singleShot(20000, this, &DiscoverNotifier::recheckSystemUpdateNeeded);
+void DiscoverNotifier::checkMemoryBudget()
+{
+    const qint64 resident = UpdatesProbe::residentMemory();
+    if (!m_modulesLoaded || resident <= m_memoryBudget || state() != NoUpdates || m_unattended)
+        return;
 
-    m_settings = new UpdatesSettings(this);
-    m_settingsWatcher = KConfigWatcher::create(m_settings->sharedConfig());
-    refreshUnattended();
-    connect(m_settingsWatcher.data(), &KConfigWatcher::configChanged, this, &DiscoverNotifier::refreshUnattended);
+    // Plugins can't be unloaded, start over with just the probe
+    qDebug() << "resident memory" << resident << "over budget" << m_memoryBudget << ", restarting";
+    if (QProcess::startDetached(QCoreApplication::applicationFilePath(), { QStringLiteral("--replace") }))
+        QCoreApplication::quit();
 }
 
-DiscoverNotifier::~DiscoverNotifier() = default;
-
 void DiscoverNotifier::showDiscover()
 {
     auto *job = new KIO::ApplicationLauncherJob(KService::serviceByDesktopName(QStringLiteral("org.kde.discover")));
@@ -113,6 +173,7 @@ void DiscoverNotifier::updateStatusNotifier()
 
     m_hasSecurityUpdates = hasSecurityUpdates;
     m_hasUpdates = hasUpdates;
+    storeState();
 
     if (state() != NoUpdates) {
         m_timer.start();
@@ -127,21 +188,39 @@ static bool isConnectionAdequate(const QNetworkConfiguration &network)
     return (network.bearerType() == QNetworkConfiguration::BearerEthernet || network.bearerType() == QNetworkConfiguration::BearerWLAN);
 }
 
+void DiscoverNotifier::storeState()
+{
+    if (!m_lightweight)
+        return;
+
+    KConfigGroup state(KSharedConfig::openConfig(), "State");
+    state.writeEntry<bool>("HasUpdates", m_hasUpdates);
+    state.writeEntry<bool>("NeedsReboot", m_needsReboot);
+    state.sync();
+}
+
 void DiscoverNotifier::refreshUnattended()
 {
     m_settings->read();
-    const auto enabled = m_settings->useUnattendedUpdates() && m_manager->isOnline() && isConnectionAdequate(m_manager->defaultConfiguration());
-    if (bool(m_unattended) == enabled)
+    const auto adequate = m_manager && m_manager->isOnline() && isConnectionAdequate(m_manager->defaultConfiguration());
+    const bool install = m_settings->useUnattendedUpdates() && adequate;
+    const bool prefetch = m_settings->prefetchUpdates() && adequate;
+    if (m_unattended && m_unattended->installs() == install && m_unattended->prefetches() == prefetch)
         return;
 
-    if (enabled) {
-        m_unattended = new UnattendedUpdates(this);
-    } else {
-        delete m_unattended;
-        m_unattended = nullptr;
+    delete m_unattended;
+    m_unattended = nullptr;
+    if (install || prefetch) {
+        m_unattended = new UnattendedUpdates(install, prefetch, this);
     }
 }
 
+void DiscoverNotifier::prefetchUpdates()
+{
+    for (BackendNotifierModule* module : qAsConst(m_backends))
+        module->prefetchUpdates();
+}
+
 
 DiscoverNotifier::State DiscoverNotifier::state() const
 {
@@ -199,6 +278,8 @@ QString DiscoverNotifier::message() const
 
 void DiscoverNotifier::recheckSystemUpdateNeeded()
 {
+    loadModules();
+
     if (!m_manager) {
         m_manager = new QNetworkConfigurationManager(this);
         connect(m_manager, &QNetworkConfigurationManager::onlineStateChanged, this, &DiscoverNotifier::stateChanged);
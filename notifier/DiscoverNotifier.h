@@ -18,6 +18,7 @@
 class KNotification;
 class QNetworkConfigurationManager;
 class UnattendedUpdates;
+class UpdatesProbe;
 
 class DiscoverNotifier : public QObject
 {
@@ -53,11 +54,16 @@ public:
     }
 
     QStringList loadedModules() const;
+    /// In lightweight mode, the backends are only loaded once there may be updates
+    bool modulesLoaded() const {
+        return m_modulesLoaded;
+    }
     bool needsReboot() const {
         return m_needsReboot;
     }
 
     void setBusy(bool isBusy);
+    void prefetchUpdates();
     bool isBusy() const {
         return m_isBusy;
     }
@@ -80,6 +86,9 @@ private:
     void showRebootNotification();
     void updateStatusNotifier();
     void refreshUnattended();
+    void loadModules();
+    void storeState();
+    void checkMemoryBudget();
 
     QList<BackendNotifierModule*> m_backends;
     QTimer m_timer;
@@ -92,6 +101,12 @@ private:
     UnattendedUpdates* m_unattended = nullptr;
     KConfigWatcher::Ptr m_settingsWatcher;
     class UpdatesSettings* m_settings;
+
+    // Lightweight mode keeps the backends unloaded until there may be updates
+    bool m_lightweight = false;
+    bool m_modulesLoaded = false;
+    qint64 m_memoryBudget = 0;
+    UpdatesProbe* m_probe = nullptr;
 };
 
 #endif //ABSTRACTKDEDMODULE_H
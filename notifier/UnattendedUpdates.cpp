@@ -12,11 +12,13 @@
 #include <QDebug>
 #include <chrono>
 
-UnattendedUpdates::UnattendedUpdates(DiscoverNotifier* parent)
+UnattendedUpdates::UnattendedUpdates(bool install, bool prefetch, DiscoverNotifier* parent)
     : QObject(parent)
+    , m_install(install)
+    , m_prefetch(prefetch)
 {
     connect(parent, &DiscoverNotifier::stateChanged, this, &UnattendedUpdates::checkNewState);
-    connect(KIdleTime::instance(), QOverload<int,int>::of(&KIdleTime::timeoutReached), this, &UnattendedUpdates::triggerUpdate);
+    connect(KIdleTime::instance(), QOverload<int,int>::of(&KIdleTime::timeoutReached), this, &UnattendedUpdates::timeoutReached);
 
     checkNewState();
 }
@@ -29,19 +31,40 @@ UnattendedUpdates::~UnattendedUpdates() noexcept
 void UnattendedUpdates::checkNewState()
 {
     DiscoverNotifier* notifier = static_cast<DiscoverNotifier*>(parent());
+    KIdleTime::instance()->removeAllIdleTimeouts();
+    m_installTimeout = m_prefetchTimeout = -1;
     if (notifier->hasUpdates()) {
         qDebug() << "waiting for an idle moment";
-        // If the system is untouched for 1 hour, trigger the unattened update
         using namespace std::chrono_literals;
-        KIdleTime::instance()->addIdleTimeout(int(std::chrono::milliseconds(1h).count()));
-    } else {
-        KIdleTime::instance()->removeAllIdleTimeouts();
+        // Downloading doesn't get in the way, it can start sooner
+        if (m_prefetch) {
+            m_prefetchTimeout = KIdleTime::instance()->addIdleTimeout(int(std::chrono::milliseconds(10min).count()));
+        }
+        // If the system is untouched for 1 hour, trigger the unattened update
+        if (m_install) {
+            m_installTimeout = KIdleTime::instance()->addIdleTimeout(int(std::chrono::milliseconds(1h).count()));
+        }
+    }
+}
+
+void UnattendedUpdates::timeoutReached(int identifier)
+{
+    if (identifier == m_installTimeout) {
+        triggerUpdate();
+        return;
+    }
+
+    DiscoverNotifier* notifier = static_cast<DiscoverNotifier*>(parent());
+    if (identifier == m_prefetchTimeout && notifier->hasUpdates() && !notifier->isBusy()) {
+        qDebug() << "downloading updates ahead of time";
+        notifier->prefetchUpdates();
     }
 }
 
 void UnattendedUpdates::triggerUpdate()
 {
     KIdleTime::instance()->removeAllIdleTimeouts();
+    m_installTimeout = m_prefetchTimeout = -1;
     DiscoverNotifier* notifier = static_cast<DiscoverNotifier*>(parent());
     if (!notifier->hasUpdates() || notifier->isBusy()) {
         return;
@@ -14,10 +14,21 @@ class UnattendedUpdates : public QObject
 {
     Q_OBJECT
 public:
-    UnattendedUpdates(DiscoverNotifier* parent);
+    UnattendedUpdates(bool install, bool prefetch, DiscoverNotifier* parent);
     ~UnattendedUpdates() override;
 
+    /// Whether the updates get installed once the system is idle
+    bool installs() const { return m_install; }
+    /// Whether the updates get downloaded once the system is idle, without installing them
+    bool prefetches() const { return m_prefetch; }
+
 private:
     void checkNewState();
+    void timeoutReached(int identifier);
     void triggerUpdate();
+
+    const bool m_install;
+    const bool m_prefetch;
+    int m_installTimeout = -1;
+    int m_prefetchTimeout = -1;
 };
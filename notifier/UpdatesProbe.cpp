@@ -0,0 +1,198 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "UpdatesProbe.h"
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTimer>
+#include <chrono>
+#include <unistd.h>
+
+static const QString s_packageKitService = QStringLiteral("org.freedesktop.PackageKit");
+static const QString s_packageKitTransaction = QStringLiteral("org.freedesktop.PackageKit.Transaction");
+// PK_FILTER_ENUM_NONE as a bitfield and PK_INFO_ENUM_BLOCKED, from PackageKit's pk-enum.h
+static const quint64 s_packageKitFilterNone = 1 << 1;
+static const uint s_packageKitInfoBlocked = 9;
+
+UpdatesProbe::UpdatesProbe(QObject* parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_delay(new QTimer(this))
+{
+    // Package managers touch many files when they refresh, only react once they're done
+    using namespace std::chrono_literals;
+    m_delay->setInterval(std::chrono::milliseconds(30s));
+    m_delay->setSingleShot(true);
+    connect(m_delay, &QTimer::timeout, this, &UpdatesProbe::check);
+
+    const QStringList paths = {
+        // PackageKit and apt package lists
+        QStringLiteral("/var/cache/PackageKit"),
+        QStringLiteral("/var/lib/apt/lists"),
+        // Flatpak remotes get new refs and summaries when they are updated
+        QStringLiteral("/var/lib/flatpak/repo/refs/remotes"),
+        QStringLiteral("/var/lib/flatpak/repo/tmp/cache/summaries"),
+        QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/flatpak/repo/refs/remotes"),
+        QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/flatpak/repo/tmp/cache/summaries"),
+    };
+    for (const auto &path : paths) {
+        if (QDir(path).exists())
+            m_watcher->addPath(path);
+    }
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &UpdatesProbe::changed);
+
+    QDBusConnection::systemBus().connect(QStringLiteral("org.freedesktop.PackageKit"), QStringLiteral("/org/freedesktop/PackageKit"),
+                                         QStringLiteral("org.freedesktop.PackageKit"), QStringLiteral("UpdatesChanged"),
+                                         this, SLOT(changed()));
+
+    // Nothing refreshes the metadata while the backends aren't loaded
+    auto daily = new QTimer(this);
+    daily->setInterval(std::chrono::milliseconds(24h));
+    connect(daily, &QTimer::timeout, this, &UpdatesProbe::refreshDue);
+    daily->start();
+
+    qDebug() << "waiting for updates, watching" << m_watcher->directories();
+}
+
+void UpdatesProbe::changed()
+{
+    if (!m_delay->isActive())
+        m_delay->start();
+}
+
+void UpdatesProbe::check()
+{
+    if (isChecking())
+        return;
+
+    m_pendingChecks = 2;
+    m_foundUpdates = false;
+    checkPackageKit();
+    checkFlatpak();
+}
+
+void UpdatesProbe::checkDone(bool hasUpdates)
+{
+    Q_ASSERT(m_pendingChecks > 0);
+    m_foundUpdates |= hasUpdates;
+    if (--m_pendingChecks == 0) {
+        qDebug() << "cached metadata has updates:" << m_foundUpdates;
+        Q_EMIT checked(m_foundUpdates);
+    }
+}
+
+void UpdatesProbe::checkPackageKit()
+{
+    auto bus = QDBusConnection::systemBus();
+    if (!bus.isConnected()) {
+        checkDone(false);
+        return;
+    }
+
+    const auto create = QDBusMessage::createMethodCall(s_packageKitService, QStringLiteral("/org/freedesktop/PackageKit"),
+                                                       QStringLiteral("org.freedesktop.PackageKit"), QStringLiteral("CreateTransaction"));
+    auto watcher = new QDBusPendingCallWatcher(bus.asyncCall(create), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher* watcher) {
+        watcher->deleteLater();
+        QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+        if (reply.isError()) {
+            qWarning() << "could not ask PackageKit for updates" << reply.error().message();
+            checkDone(false);
+            return;
+        }
+
+        auto bus = QDBusConnection::systemBus();
+        m_packageKitTransaction = reply.value().path();
+        m_packageKitUpdates = 0;
+        bus.connect(s_packageKitService, m_packageKitTransaction, s_packageKitTransaction, QStringLiteral("Package"),
+                    this, SLOT(packageKitPackage(uint,QString,QString)));
+        bus.connect(s_packageKitService, m_packageKitTransaction, s_packageKitTransaction, QStringLiteral("Finished"),
+                    this, SLOT(packageKitFinished(uint,uint)));
+
+        // PackageKit answers from its cache, it only goes online to refresh it
+        auto getUpdates = QDBusMessage::createMethodCall(s_packageKitService, m_packageKitTransaction, s_packageKitTransaction, QStringLiteral("GetUpdates"));
+        getUpdates << QVariant::fromValue<quint64>(s_packageKitFilterNone);
+        auto getWatcher = new QDBusPendingCallWatcher(bus.asyncCall(getUpdates), this);
+        connect(getWatcher, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher* watcher) {
+            watcher->deleteLater();
+            if (watcher->isError()) {
+                qWarning() << "could not get the updates from PackageKit" << watcher->error().message();
+                packageKitFinished(0, 0);
+            }
+        });
+    });
+}
+
+void UpdatesProbe::packageKitPackage(uint info, const QString &/*packageId*/, const QString &/*summary*/)
+{
+    if (info != s_packageKitInfoBlocked)
+        ++m_packageKitUpdates;
+}
+
+void UpdatesProbe::packageKitFinished(uint /*exit*/, uint /*runtime*/)
+{
+    if (m_packageKitTransaction.isEmpty())
+        return;
+
+    auto bus = QDBusConnection::systemBus();
+    bus.disconnect(s_packageKitService, m_packageKitTransaction, s_packageKitTransaction, QStringLiteral("Package"),
+                   this, SLOT(packageKitPackage(uint,QString,QString)));
+    bus.disconnect(s_packageKitService, m_packageKitTransaction, s_packageKitTransaction, QStringLiteral("Finished"),
+                   this, SLOT(packageKitFinished(uint,uint)));
+    m_packageKitTransaction.clear();
+    checkDone(m_packageKitUpdates > 0);
+}
+
+void UpdatesProbe::checkFlatpak()
+{
+    const QString flatpak = QStandardPaths::findExecutable(QStringLiteral("flatpak"));
+    if (flatpak.isEmpty()) {
+        checkDone(false);
+        return;
+    }
+
+    // Compares the installed refs with the summaries of the remotes flatpak has on disk,
+    // in a process of its own so that libflatpak doesn't stay in memory
+    auto process = new QProcess(this);
+    connect(process, &QProcess::errorOccurred, this, [this, process] (QProcess::ProcessError error) {
+        // Otherwise it still finishes
+        if (error == QProcess::FailedToStart) {
+            qWarning() << "could not ask flatpak for updates" << process->errorString();
+            process->deleteLater();
+            checkDone(false);
+        }
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, process] (int exitCode, QProcess::ExitStatus exitStatus) {
+        process->deleteLater();
+        const bool ok = exitStatus == QProcess::NormalExit && exitCode == 0;
+        if (!ok)
+            qWarning() << "could not get the updates from flatpak" << process->readAllStandardError();
+        checkDone(ok && !process->readAllStandardOutput().trimmed().isEmpty());
+    });
+    process->start(flatpak, { QStringLiteral("remote-ls"), QStringLiteral("--updates"), QStringLiteral("--cached"), QStringLiteral("--columns=ref") });
+}
+
+qint64 UpdatesProbe::residentMemory()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+
+    // Sizes in pages: total program size, then resident set
+    const auto fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return 0;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+}
@@ -0,0 +1,60 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QObject>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * Tells whether there are updates without loading any backend.
+ *
+ * It asks PackageKit for the updates it knows about and Flatpak for the ones
+ * listed in the summaries it already downloaded, neither of them goes to the
+ * network for it. The check runs when the metadata on disk changes or
+ * PackageKit says its updates changed, anything else needs the backends to
+ * refresh the metadata, which is due once a day.
+ */
+class UpdatesProbe : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UpdatesProbe(QObject* parent = nullptr);
+
+    /// Looks for updates in the cached metadata, checked() is emitted with the result
+    void check();
+    bool isChecking() const {
+        return m_pendingChecks > 0;
+    }
+
+    /// @returns the resident memory of the process in bytes, 0 if it can't be told
+    static qint64 residentMemory();
+
+Q_SIGNALS:
+    /// @p hasUpdates tells whether any of the package managers has updates in its cache
+    void checked(bool hasUpdates);
+    /// The metadata hasn't been refreshed for a day, only the backends can do it
+    void refreshDue();
+
+private Q_SLOTS:
+    void changed();
+    void packageKitPackage(uint info, const QString &packageId, const QString &summary);
+    void packageKitFinished(uint exit, uint runtime);
+
+private:
+    void checkPackageKit();
+    void checkFlatpak();
+    void checkDone(bool hasUpdates);
+
+    QFileSystemWatcher* const m_watcher;
+    QTimer* const m_delay;
+    int m_pendingChecks = 0;
+    bool m_foundUpdates = false;
+    QString m_packageKitTransaction;
+    int m_packageKitUpdates = 0;
+};
@@ -0,0 +1,70 @@
+/*
+ *   SPDX-FileCopyrightText: 2021 Zhang He Gang <zhanghegang@jingos.com>
+ *
+ *   SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "DiscoverNotifier.h"
+#include "UpdatesProbe.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <QStandardPaths>
+#include <QtTest>
+
+// What starting the notifier without its backends may cost, the probe is all it needs
+static const qint64 s_lightweightBudget = 8 * 1024 * 1024;
+
+class DiscoverNotifierTest : public QObject
+{
+    Q_OBJECT
+private:
+    void setLightweight(bool lightweight)
+    {
+        const auto config = KSharedConfig::openConfig();
+        KConfigGroup(config, "Behavior").writeEntry<bool>("Lightweight", lightweight);
+        KConfigGroup state(config, "State");
+        state.writeEntry<bool>("HasUpdates", false);
+        state.writeEntry<bool>("NeedsReboot", false);
+        config->sync();
+    }
+
+    qint64 m_resident = 0;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        m_resident = UpdatesProbe::residentMemory();
+        if (m_resident == 0)
+            QSKIP("the resident memory can't be told on this system");
+    }
+
+    // Runs first, the backends can't be unloaded once the full notifier loaded them
+    void testLightweight()
+    {
+        setLightweight(true);
+        DiscoverNotifier notifier;
+        QVERIFY(!notifier.modulesLoaded());
+        QVERIFY(notifier.loadedModules().isEmpty());
+
+        const qint64 resident = UpdatesProbe::residentMemory();
+        qDebug() << "lightweight notifier resident memory" << resident / 1024 << "KiB, started at" << m_resident / 1024 << "KiB";
+        QVERIFY2(resident - m_resident < s_lightweightBudget, qPrintable(QStringLiteral("grew by %1 KiB").arg((resident - m_resident) / 1024)));
+        m_resident = qMax(m_resident, resident);
+    }
+
+    void testFull()
+    {
+        setLightweight(false);
+        DiscoverNotifier notifier;
+        QVERIFY(notifier.modulesLoaded());
+
+        const qint64 resident = UpdatesProbe::residentMemory();
+        qDebug() << "notifier resident memory with" << notifier.loadedModules() << resident / 1024 << "KiB, lightweight took" << m_resident / 1024 << "KiB";
+    }
+};
+
+QTEST_MAIN(DiscoverNotifierTest)
+
+#include "DiscoverNotifierTest.moc"